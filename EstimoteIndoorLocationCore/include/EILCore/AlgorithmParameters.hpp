@@ -0,0 +1,58 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+
+namespace eil {
+
+/**
+ * Tunable parameters of the positioning algorithm.
+ *
+ * Default values correspond to the parameters the SDK uses for Estimote Location Beacons when no newer revision was fetched.
+ */
+struct AlgorithmParameters
+{
+    /** Expected RSSI one meter away from a beacon, in dBm. */
+    double measuredPower = -68.0;
+    /** Exponent of the log-distance path loss model. */
+    double pathLossExponent = 2.2;
+    /** Standard deviation of a smoothed RSSI reading around the path loss model, in dB. */
+    double rssiNoise = 6.0;
+    /** Time constant of the per-beacon RSSI smoothing, in seconds. */
+    double rssiTimeConstant = 2.0;
+    /** Time after which a beacon that was not heard from is no longer used, in seconds. */
+    double beaconTimeout = 5.0;
+
+    /** Number of particles used to represent the position of the user. */
+    int particleCount = 400;
+    /** Maximum walking speed of the user, in meters per second. Drives the motion model. */
+    double maxWalkingSpeed = 1.5;
+    /** Minimum standard deviation of the motion model per update, in meters. */
+    double minimumMotionNoise = 0.1;
+    /**
+     * Beacons farther than this from the current estimate, in meters, are left out of an update unless they are among
+     * the `strongestBeaconCount` strongest. Bounds the cost of an update in venues with many beacons. Zero uses all beacons heard.
+     */
+    double beaconSelectionRadius = 20.0;
+    /** Number of strongest beacons used in every update regardless of their distance from the estimate. */
+    int strongestBeaconCount = 6;
+    /**
+     * Seed of all random sampling of the filter. With a non-zero seed, the same samples always produce bit-identical
+     * position updates; each location derives its own stream from the seed and its content. Zero seeds from `std::random_device`.
+     */
+    uint64_t randomSeed = 0;
+    /** Edge of a cell of the precomputed signal map, in meters. See `SignalMap`. */
+    double signalMapCellSize = 0.5;
+
+    /** Interval between consecutive position updates, in seconds. */
+    double updateInterval = 1.0;
+    /** Time after the first beacon sample before position updates are delivered, in seconds. */
+    double warmUpDuration = 6.0;
+    /** Whether position updates should carry orientation derived from the walking direction. */
+    bool provideOrientation = false;
+    /** Minimum displacement between updates for the walking direction to be derived, in meters. */
+    double minimumDisplacementForOrientation = 0.3;
+};
+
+} // namespace eil
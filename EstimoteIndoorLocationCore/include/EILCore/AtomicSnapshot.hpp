@@ -0,0 +1,79 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace eil {
+
+/**
+ * Value published by a single writer thread and read by any number of threads without locks.
+ *
+ * A sequence lock: readers never block the writer and retry only if they overlap with a store, so reading costs
+ * a handful of loads. The value is kept in atomic words, so concurrent access is well defined.
+ */
+template <typename T>
+class AtomicSnapshot
+{
+    static_assert(std::is_trivially_copyable<T>::value, "AtomicSnapshot requires a trivially copyable type");
+
+public:
+    AtomicSnapshot() { store(T()); }
+
+    explicit AtomicSnapshot(const T &value) { store(value); }
+
+    AtomicSnapshot(const AtomicSnapshot &) = delete;
+    AtomicSnapshot &operator=(const AtomicSnapshot &) = delete;
+
+    /**
+     * Publishes a new value. Must only be called from one thread at a time.
+     *
+     * @param value The value.
+     */
+    void store(const T &value)
+    {
+        uint64_t words[kWordCount] = {};
+        std::memcpy(words, &value, sizeof(T));
+        uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWordCount; i++)
+        {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /** Returns the most recently published value. Can be called from any thread. */
+    T load() const
+    {
+        uint64_t words[kWordCount];
+        uint64_t before;
+        uint64_t after;
+        do
+        {
+            before = _sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWordCount; i++)
+            {
+                words[i] = _words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t kWordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> _sequence{0};
+    std::atomic<uint64_t> _words[kWordCount];
+};
+
+} // namespace eil
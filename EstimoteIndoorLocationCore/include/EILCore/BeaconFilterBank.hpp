@@ -0,0 +1,88 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/BeaconSample.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace eil {
+
+/** Smoothed signal statistics of a single beacon. */
+struct BeaconState
+{
+    /** Exponentially smoothed RSSI, in dBm. */
+    double rssi = 0.0;
+    /** Exponentially smoothed variance of the RSSI, in dB². */
+    double variance = 0.0;
+    /** Time of the first sample. */
+    double firstSeen = 0.0;
+    /** Time of the most recent sample. */
+    double lastSeen = 0.0;
+    /** Number of samples received. */
+    uint32_t sampleCount = 0;
+};
+
+/**
+ * Keeps per-beacon RSSI statistics built from the raw stream of beacon samples.
+ *
+ * Smoothing is time based, so irregular advertising intervals and dropped packets do not change the filter response.
+ * Not thread-safe; all calls have to be serialized by the owner.
+ */
+class BeaconFilterBank
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param timeConstant Time constant of the exponential smoothing, in seconds.
+     */
+    explicit BeaconFilterBank(double timeConstant);
+
+    /**
+     * Updates statistics of the beacon that sent the sample.
+     *
+     * @param sample Received beacon sample.
+     */
+    void addSample(const BeaconSample &sample);
+
+    /**
+     * Returns statistics for the beacon.
+     *
+     * @param beacon Compact beacon identifier.
+     * @return Statistics or `nullptr` if no sample was received from the beacon.
+     */
+    const BeaconState *stateForBeacon(BeaconId beacon) const;
+
+    /**
+     * Forgets beacons which were not heard from for a given time.
+     *
+     * @param timestamp Current time.
+     * @param timeout Time after which a beacon is forgotten, in seconds.
+     */
+    void removeStaleBeacons(double timestamp, double timeout);
+
+    /**
+     * Sets statistics of the beacon, replacing any gathered so far. Used to resume from saved statistics.
+     *
+     * @param beacon Compact beacon identifier.
+     * @param state Statistics of the beacon. States without samples are ignored.
+     */
+    void restoreState(BeaconId beacon, const BeaconState &state);
+
+    /** Statistics of all beacons, keyed by beacon. */
+    const std::unordered_map<BeaconId, BeaconState> &states() const { return _states; }
+
+    /** Forgets all beacons. */
+    void reset() { _states.clear(); }
+
+    /** Number of beacons with statistics. */
+    size_t count() const { return _states.size(); }
+
+private:
+    double _timeConstant;
+    std::unordered_map<BeaconId, BeaconState> _states;
+};
+
+} // namespace eil
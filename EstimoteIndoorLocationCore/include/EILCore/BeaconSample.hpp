@@ -0,0 +1,51 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace eil {
+
+/**
+ * Compact identifier of a beacon used on the hot path instead of its string identifier.
+ *
+ * Use `beaconIdFromIdentifier` to obtain it from `EILPositionedBeacon.identifier`.
+ */
+typedef uint64_t BeaconId;
+
+/**
+ * Computes the compact identifier for a beacon identifier (MAC address or identifier).
+ *
+ * Identifiers are compared case-insensitively, the same way Estimote Cloud treats them.
+ *
+ * @param identifier Beacon identifier.
+ * @return Compact beacon identifier.
+ */
+BeaconId beaconIdFromIdentifier(const std::string &identifier);
+
+/**
+ * Computes the compact identifier for an iBeacon triple, for apps which range beacons by proximity UUID instead of
+ * scanning their identifiers. It never equals the compact identifier of a beacon identifier in practice.
+ *
+ * @param proximityUUID Proximity UUID of the beacon; compared case-insensitively.
+ * @param major Major value of the beacon.
+ * @param minor Minor value of the beacon.
+ * @return Compact beacon identifier.
+ */
+BeaconId beaconIdFromIBeacon(const std::string &proximityUUID, uint16_t major, uint16_t minor);
+
+/**
+ * A single received beacon advertisement.
+ */
+struct BeaconSample
+{
+    /** Identifier of the beacon that sent the advertisement. */
+    BeaconId beacon = 0;
+    /** Time of reception in seconds. Any monotonic clock can be used as long as it is used consistently. */
+    double timestamp = 0.0;
+    /** Received signal strength in dBm. */
+    int rssi = 0;
+};
+
+} // namespace eil
@@ -0,0 +1,90 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/BeaconSample.hpp"
+#include "EILCore/Location.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eil {
+
+/** Single storey of a building. */
+struct Floor
+{
+    /** Level of the floor; 0 for the ground floor, negative below it. Levels increase upwards. */
+    int level = 0;
+    /** Location covering the floor. */
+    LocationRef location;
+
+    Floor() = default;
+    Floor(int level, LocationRef location) : level(level), location(std::move(location)) {}
+};
+
+/**
+ * Groups the locations of the floors of a multi-storey building. Object is immutable.
+ *
+ * Floors are positioned together by `PositioningEngine` once a `FloorDetector` for the building is set. Buildings are
+ * shared as `BuildingRef`.
+ */
+class Building
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param identifier Identifier of the building.
+     * @param floors Floors of the building, in any order. Levels have to be unique; floors without a location are
+     *               dropped.
+     * @param floorHeight Height of a storey, floor to floor, in meters. Used to tell floors apart by air pressure.
+     */
+    Building(std::string identifier, std::vector<Floor> floors, double floorHeight = 4.0);
+
+    /** Identifier of the building. */
+    const std::string &identifier() const { return _identifier; }
+
+    /** Floors of the building, sorted by level, lowest first. */
+    const std::vector<Floor> &floors() const { return _floors; }
+
+    /** Height of a storey, floor to floor, in meters. */
+    double floorHeight() const { return _floorHeight; }
+
+    /**
+     * Finds the floor with a given level.
+     *
+     * @param level Level of the floor.
+     * @return Index of the floor in `floors`, or a negative value if there is no such floor.
+     */
+    int indexOfLevel(int level) const;
+
+    /**
+     * Finds the floor of a location.
+     *
+     * @param location The location; matched by identity, then by identifier if it has one.
+     * @return Index of the floor in `floors`, or a negative value if the location is not a floor of the building.
+     */
+    int indexOfLocation(const Location &location) const;
+
+    /**
+     * Finds the floor a beacon is placed on.
+     *
+     * @param beacon Compact beacon identifier.
+     * @return Index of the floor in `floors`, or a negative value if no floor has the beacon. Beacons listed by
+     *         several floors belong to the lowest of them.
+     */
+    int floorIndexOfBeacon(BeaconId beacon) const;
+
+private:
+    std::string _identifier;
+    std::vector<Floor> _floors;
+    double _floorHeight;
+    std::unordered_map<BeaconId, int> _floorsByBeacon;
+};
+
+/** Shared, immutable reference to a building. */
+typedef std::shared_ptr<const Building> BuildingRef;
+
+} // namespace eil
@@ -0,0 +1,62 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace eil {
+
+/**
+ * Queue on which handlers of the positioning core are invoked. Counterpart of a `dispatch_queue_t` delegate queue.
+ *
+ * Implement it on top of libdispatch, a run loop or any other executor to deliver updates where the application
+ * wants them; `SerialDispatchQueue` is a portable implementation with its own thread.
+ */
+class DispatchQueue
+{
+public:
+    virtual ~DispatchQueue() = default;
+
+    /**
+     * Schedules the block for asynchronous execution. Blocks have to be executed in the order they were scheduled.
+     *
+     * @param block The block.
+     */
+    virtual void async(std::function<void()> block) = 0;
+};
+
+/**
+ * Serial queue executing blocks one after another on a dedicated thread.
+ */
+class SerialDispatchQueue : public DispatchQueue
+{
+public:
+    SerialDispatchQueue();
+
+    /** Executes all blocks scheduled so far, then stops the thread. */
+    ~SerialDispatchQueue() override;
+
+    SerialDispatchQueue(const SerialDispatchQueue &) = delete;
+    SerialDispatchQueue &operator=(const SerialDispatchQueue &) = delete;
+
+    void async(std::function<void()> block) override;
+
+    /** Blocks the calling thread until all blocks scheduled so far were executed. Must not be called from the queue itself. */
+    void waitUntilIdle();
+
+private:
+    void run();
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<std::function<void()>> _blocks;
+    bool _executing = false;
+    bool _stopping = false;
+    std::thread _thread;
+};
+
+} // namespace eil
@@ -0,0 +1,45 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+/** Version of the portable positioning core. Follows the version of the iOS Indoor Location SDK. */
+#define EIL_CORE_VERSION_STRING "3.0.0-alpha.2"
+
+/** Library header, include this to include all of the public types of the positioning core. */
+
+// Location data structures.
+#include "EILCore/Building.hpp"
+#include "EILCore/Geometry.hpp"
+#include "EILCore/Location.hpp"
+#include "EILCore/LocationBuilder.hpp"
+#include "EILCore/LocationCoding.hpp"
+#include "EILCore/NavigationGraph.hpp"
+#include "EILCore/PinIndex.hpp"
+#include "EILCore/PolygonIndex.hpp"
+#include "EILCore/PolygonSampler.hpp"
+#include "EILCore/SegmentIndex.hpp"
+#include "EILCore/TransformedLocation.hpp"
+
+// Positioning.
+#include "EILCore/AlgorithmParameters.hpp"
+#include "EILCore/AtomicSnapshot.hpp"
+#include "EILCore/BeaconSample.hpp"
+#include "EILCore/BeaconFilterBank.hpp"
+#include "EILCore/DispatchQueue.hpp"
+#include "EILCore/FloorDetector.hpp"
+#include "EILCore/GeofenceMonitor.hpp"
+#include "EILCore/InertialFusion.hpp"
+#include "EILCore/ParameterStore.hpp"
+#include "EILCore/ParticleFilter.hpp"
+#include "EILCore/PositionBatch.hpp"
+#include "EILCore/PositionPredictor.hpp"
+#include "EILCore/PositionUpdate.hpp"
+#include "EILCore/PositioningEngine.hpp"
+#include "EILCore/PositioningMetrics.hpp"
+#include "EILCore/PositioningSnapshot.hpp"
+#include "EILCore/Random.hpp"
+#include "EILCore/SensorSample.hpp"
+#include "EILCore/SignalMap.hpp"
+#include "EILCore/SpscRingBuffer.hpp"
+
+// Recording and replay.
+#include "EILCore/ScanTrace.hpp"
+#include "EILCore/TraceReplay.hpp"
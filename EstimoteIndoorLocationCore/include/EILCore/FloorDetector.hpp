@@ -0,0 +1,105 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/BeaconFilterBank.hpp"
+#include "EILCore/Building.hpp"
+#include "EILCore/InertialFusion.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace eil {
+
+/**
+ * Tells which floor of a building the user is on, from beacon signals and air pressure.
+ *
+ * Every floor is scored with the mean smoothed RSSI of its strongest beacons heard recently. Another floor takes over
+ * only after it has scored `switchMargin` above the current floor for `dwellTime`, which keeps the floor from
+ * flickering where signals leak through ceilings. With a barometer the relative altitude since the last floor change
+ * is tracked as well. A climb or descent of about a storey is enough to switch to the floor it points at, as long as
+ * that floor is heard at all, while an unchanged altitude doubles the margin. Slow weather-induced drift of the
+ * pressure is followed while the altitude stays put. A floor nobody hears never takes over, so the current floor is
+ * kept while it and every other floor are silent.
+ *
+ * Used by `PositioningEngine::setFloorDetector`, which keeps the filters of all floors running and delivers position
+ * updates of the current floor only, so a floor change needs no re-acquisition. Not thread-safe; all calls have to be
+ * serialized by the owner.
+ */
+class FloorDetector
+{
+public:
+    /** Block invoked when the current floor changes. */
+    typedef std::function<void(const Floor &floor, double timestamp)> FloorChangeHandler;
+
+    /**
+     * Designated initializer.
+     *
+     * @param building The building. Must not be null.
+     * @param switchMargin Score advantage another floor needs to take over, in dB.
+     * @param dwellTime Time another floor has to keep the advantage before it takes over, in seconds.
+     * @param strongestBeaconCount Number of strongest beacons of a floor averaged into its score.
+     */
+    explicit FloorDetector(BuildingRef building, double switchMargin = 6.0, double dwellTime = 2.0,
+                           size_t strongestBeaconCount = 3);
+
+    /** The building. */
+    const BuildingRef &building() const { return _building; }
+
+    /**
+     * Sets the block invoked when the current floor changes, including the first detection.
+     *
+     * @param handler The block. Can be empty.
+     */
+    void setFloorChangeHandler(FloorChangeHandler handler) { _floorChangeHandler = std::move(handler); }
+
+    /** Index of the current floor in `Building::floors`, or a negative value until a beacon of any floor is heard. */
+    int currentFloorIndex() const { return _currentFloor; }
+
+    /** The current floor, `nullptr` until a beacon of any floor is heard. */
+    const Floor *currentFloor() const { return _currentFloor < 0 ? nullptr : &_building->floors()[_currentFloor]; }
+
+    /**
+     * Re-evaluates the floor.
+     *
+     * @param timestamp Current time, on the clock of the beacon samples.
+     * @param beacons Smoothed beacon statistics.
+     * @param beaconTimeout Beacons not heard for this long are ignored, in seconds.
+     * @param motion Current motion of the user with the air pressure, or `nullptr` without inertial sensors.
+     * @return true if the current floor changed.
+     */
+    bool update(double timestamp, const BeaconFilterBank &beacons, double beaconTimeout, const MotionState *motion);
+
+    /** Forgets the current floor and the altitude reference. */
+    void reset();
+
+private:
+    /** Computes `_scores` from the beacon statistics. */
+    void scoreFloors(double timestamp, const BeaconFilterBank &beacons, double beaconTimeout);
+
+    /** Switches to a floor and takes the current pressure as the altitude reference. */
+    void changeFloor(int floor, double timestamp, double pressure);
+
+    BuildingRef _building;
+    double _switchMargin;
+    double _dwellTime;
+    size_t _strongestBeaconCount;
+    FloorChangeHandler _floorChangeHandler;
+
+    int _currentFloor = -1;
+    /** Floor about to take over and the time it started to qualify, or a negative value. */
+    int _candidateFloor = -1;
+    double _candidateSince = 0.0;
+    /** Air pressure at the current floor in kilopascals, zero if unknown. */
+    double _referencePressure = 0.0;
+    double _lastUpdate = 0.0;
+
+    /** Score of each floor, negative infinity for floors with no beacon heard. */
+    std::vector<double> _scores;
+    /** Strongest RSSI values of each floor, `_strongestBeaconCount` per floor, strongest first. */
+    std::vector<double> _strongest;
+    std::vector<size_t> _strongestCounts;
+};
+
+} // namespace eil
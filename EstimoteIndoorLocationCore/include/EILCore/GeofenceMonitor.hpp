@@ -0,0 +1,215 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/BeaconSample.hpp"
+#include "EILCore/DispatchQueue.hpp"
+#include "EILCore/Location.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace eil {
+
+/** The possible states of a monitored location. Counterpart of `EILLocationState`. */
+enum class LocationState
+{
+    /** The state of the monitored location is unknown. */
+    Unknown,
+    /** The user is inside the location. */
+    Inside,
+    /** The user is outside the location. */
+    Outside,
+};
+
+/**
+ * Determines whether the user is inside or outside of monitored locations. Backs `startMonitoringForLocation:`.
+ *
+ * The user is inside a location while any of its beacons is heard with at least `minimumRssi`, and outside once none
+ * was heard for `exitTimeout` seconds. Beacons are indexed by their identifier and, if known, by their iBeacon triple,
+ * so a sample only touches the locations containing its beacon, and an exit is found through a queue of deadlines of
+ * the locations the user is inside of. The cost of a sample therefore does not depend on the number of monitored
+ * locations, which can go into thousands.
+ *
+ * Time is driven by the timestamps of the samples and by `advanceTo`, like in `PositioningEngine`.
+ * Not thread-safe; all calls have to be serialized by the owner. The state handler is invoked synchronously, where it
+ * may start or stop monitoring, or on the delegate queue if one is set.
+ */
+class GeofenceMonitor
+{
+public:
+    /** Block invoked whenever the state of a monitored location changes. */
+    typedef std::function<void(LocationState state, const Location &location)> StateHandler;
+
+    /** Deferred change of the state of a monitored location. */
+    struct StateChange
+    {
+        /** Time of the change, on the clock of the samples. */
+        double timestamp;
+        LocationState state;
+        LocationRef location;
+    };
+
+    /**
+     * Designated initializer.
+     *
+     * @param exitTimeout Time after the last qualifying sample after which the user is outside, in seconds.
+     * @param minimumRssi Samples weaker than this are ignored, in dBm.
+     */
+    explicit GeofenceMonitor(double exitTimeout = 10.0, int minimumRssi = -95);
+
+    /**
+     * Sets the block invoked whenever the state of a monitored location changes.
+     *
+     * @param handler The block. Can be empty.
+     */
+    void setStateHandler(StateHandler handler);
+
+    /** The block invoked whenever the state of a monitored location changes, `nullptr` if none. */
+    const std::shared_ptr<const StateHandler> &stateHandler() const { return _stateHandler; }
+
+    /**
+     * Sets the queue on which the state handler is invoked, like `PositioningEngine::setDelegateQueue`. The handler then
+     * runs concurrently with the monitor and must not call into it directly.
+     *
+     * @param queue A serial queue or `nullptr` to invoke the handler synchronously.
+     */
+    void setDelegateQueue(std::shared_ptr<DispatchQueue> queue) { _delegateQueue = std::move(queue); }
+
+    /** The queue on which the state handler is invoked, `nullptr` if it is invoked synchronously. */
+    const std::shared_ptr<DispatchQueue> &delegateQueue() const { return _delegateQueue; }
+
+    /**
+     * Defers state changes to save wake-ups in the background. Changes are kept until the oldest of them is older than
+     * the latency, or until `flushStateChanges` is called, e.g. by `PositioningEngine` when it hands over a batch.
+     * States returned by `stateForLocation` are always current.
+     *
+     * @param latency Maximum delay of a state change, in seconds. Zero delivers changes right away, which is the
+     *                default, and hands over deferred ones.
+     */
+    void setMaximumDeliveryLatency(double latency);
+
+    /** Invokes the state handler with all deferred state changes right away, oldest first. */
+    void flushStateChanges();
+
+    /**
+     * Hands all deferred state changes over to the caller instead of the state handler, e.g. to invoke the handler on
+     * another thread.
+     *
+     * @param changes Receives the changes, oldest first. Previous contents are replaced.
+     */
+    void takeStateChanges(std::vector<StateChange> &changes);
+
+    /** Number of deferred state changes. */
+    size_t pendingStateChangeCount() const { return _pendingStateChanges.size(); }
+
+    /**
+     * Starts monitoring the location. Its state is unknown until a beacon of it is heard or `exitTimeout` passes.
+     *
+     * @param location The location.
+     * @return false if a location with the same identifier is already monitored.
+     */
+    bool startMonitoring(LocationRef location);
+
+    /**
+     * Stops monitoring the location.
+     *
+     * @param location The location; matched by identifier.
+     */
+    void stopMonitoring(const Location &location);
+
+    /**
+     * Determines the state of the monitored location.
+     *
+     * @param location The location; matched by identifier.
+     * @return The state, `LocationState::Unknown` if the location is not monitored.
+     */
+    LocationState stateForLocation(const Location &location) const
+    {
+        return stateForLocationWithIdentifier(location.identifier());
+    }
+
+    /**
+     * Determines the state of the monitored location identified by its identifier.
+     *
+     * @param identifier Identifier of the location.
+     * @return The state, `LocationState::Unknown` if the location is not monitored.
+     */
+    LocationState stateForLocationWithIdentifier(const std::string &identifier) const;
+
+    /** All monitored locations, in no particular order. */
+    std::vector<LocationRef> monitoredLocations() const;
+
+    /** Number of monitored locations. */
+    size_t monitoredLocationCount() const { return _regionsByIdentifier.size(); }
+
+    /**
+     * Updates the states of the locations containing the beacon that sent the sample.
+     *
+     * @param sample Received beacon sample. Its `beacon` may come from `beaconIdFromIdentifier` or `beaconIdFromIBeacon`.
+     */
+    void processSample(const BeaconSample &sample);
+
+    /**
+     * Advances time without a sample, moving locations not heard from for `exitTimeout` to the outside state.
+     *
+     * @param timestamp Current time, on the clock of the samples.
+     */
+    void advanceTo(double timestamp);
+
+private:
+    struct Region
+    {
+        LocationRef location;
+        LocationState state = LocationState::Unknown;
+        /** Time of the last qualifying sample, or of the start of monitoring if none was heard since. */
+        double lastHeard = 0.0;
+        /** Incremented whenever the slot is reused, invalidating deadlines queued for the previous location. */
+        uint32_t generation = 0;
+        bool isActive = false;
+        bool hasDeadline = false;
+    };
+
+    struct Deadline
+    {
+        double timestamp;
+        size_t region;
+        uint32_t generation;
+
+        bool operator>(const Deadline &other) const { return timestamp > other.timestamp; }
+    };
+
+    std::vector<BeaconId> beaconIdsOfLocation(const Location &location) const;
+    void startPendingRegions(double timestamp);
+    void expireRegions(double timestamp);
+    void scheduleDeadline(size_t region);
+    void setState(size_t region, LocationState state, double timestamp);
+    void deliverDueStateChanges(double timestamp);
+
+    double _exitTimeout;
+    int _minimumRssi;
+    // Kept behind a shared pointer, so blocks scheduled on the delegate queue can cheaply keep it alive.
+    std::shared_ptr<const StateHandler> _stateHandler;
+    std::shared_ptr<DispatchQueue> _delegateQueue;
+    double _maximumDeliveryLatency = 0.0;
+    std::vector<StateChange> _pendingStateChanges;
+    std::vector<StateChange> _deliveredStateChanges;
+
+    std::vector<Region> _regions;
+    std::vector<size_t> _freeRegions;
+    std::vector<size_t> _pendingRegions;
+    std::unordered_map<std::string, size_t> _regionsByIdentifier;
+    std::unordered_map<BeaconId, std::vector<size_t>> _regionsByBeacon;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> _deadlines;
+    // Copy of the regions of the current beacon with their generations, so the state handler can stop and start
+    // monitoring while they are updated without a reused slot being taken for the region it held before.
+    std::vector<std::pair<size_t, uint32_t>> _affectedRegions;
+};
+
+} // namespace eil
@@ -0,0 +1,256 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <cmath>
+#include <type_traits>
+
+namespace eil {
+
+/** A constant for undefined orientation. Mirrors `EIL_ORIENTATION_UNDEFINED`. */
+constexpr double kOrientationUndefined = -1.0;
+
+/**
+ * Represents a geometrical point. Counterpart of `EILPoint`.
+ *
+ * Coordinates are expressed in meters, in the Cartesian coordinate system of the location.
+ */
+struct Point
+{
+    /** X coordinate of the point. */
+    double x = 0.0;
+    /** Y coordinate of the point. */
+    double y = 0.0;
+
+    constexpr Point() = default;
+    constexpr Point(double x, double y) : x(x), y(y) {}
+
+    /**
+     * Translates the point by a given vector (dX, dY) and returns a new point.
+     *
+     * @param dX Value of translation on X axis.
+     * @param dY Value of translation on Y axis.
+     * @return A new point translated by (dX, dY).
+     */
+    Point translatedBy(double dX, double dY) const { return Point(x + dX, y + dY); }
+
+    /**
+     * Computes distance between given point and this point.
+     *
+     * @param point Given point to which distance will be computed.
+     * @return Distance between points.
+     */
+    double distanceTo(const Point &point) const { return std::hypot(point.x - x, point.y - y); }
+
+    /**
+     * Computes the length of the vector represented by the point
+     * i.e. distance from the point to the (0,0).
+     *
+     * @return Length of the vector.
+     */
+    double length() const { return std::hypot(x, y); }
+
+    /**
+     * Rotates the point around a center and returns a new point.
+     *
+     * @param center Center of the rotation.
+     * @param angle Angle of the rotation in degrees, counted clockwise like orientations.
+     * @return A new point rotated around the center.
+     */
+    Point rotatedAround(const Point &center, double angle) const;
+};
+
+inline bool operator==(const Point &a, const Point &b) { return a.x == b.x && a.y == b.y; }
+inline bool operator!=(const Point &a, const Point &b) { return !(a == b); }
+
+/**
+ * Represents a geometrical point with additional information about orientation. Counterpart of `EILOrientedPoint`.
+ *
+ * Orientation is in degrees, counted clockwise from the [0, 1] vector. If not defined takes `kOrientationUndefined` value.
+ */
+struct OrientedPoint : Point
+{
+    /** Orientation of the point. */
+    double orientation = kOrientationUndefined;
+
+    constexpr OrientedPoint() = default;
+    constexpr OrientedPoint(double x, double y, double orientation = kOrientationUndefined)
+        : Point(x, y), orientation(orientation) {}
+    constexpr OrientedPoint(const Point &point, double orientation = kOrientationUndefined)
+        : Point(point), orientation(orientation) {}
+
+    /** @return true if the orientation of the point is defined. */
+    bool hasOrientation() const { return orientation != kOrientationUndefined; }
+
+    /** @see Point::translatedBy */
+    OrientedPoint translatedBy(double dX, double dY) const { return OrientedPoint(x + dX, y + dY, orientation); }
+
+    /** @see Point::rotatedAround. A defined orientation turns along and stays in the range [0, 360). */
+    OrientedPoint rotatedAround(const Point &center, double angle) const;
+};
+
+/**
+ * Represents a geometrical line segment with additional information about orientation. Counterpart of `EILOrientedLineSegment`.
+ */
+struct OrientedLineSegment
+{
+    /** Coordinates of the first end point of the line segment. */
+    Point point1;
+    /** Coordinates of the second end point of the line segment. */
+    Point point2;
+    /** Orientation associated with the line segment. If not defined takes `kOrientationUndefined` value. */
+    double orientation = kOrientationUndefined;
+
+    constexpr OrientedLineSegment() = default;
+    constexpr OrientedLineSegment(const Point &point1, const Point &point2, double orientation = kOrientationUndefined)
+        : point1(point1), point2(point2), orientation(orientation) {}
+
+    /** @return Length of the line segment. */
+    double length() const { return point1.distanceTo(point2); }
+
+    /** @return Center point of the line segment. It has the same orientation as the line segment. */
+    OrientedPoint centerPoint() const
+    {
+        return OrientedPoint((point1.x + point2.x) / 2.0, (point1.y + point2.y) / 2.0, orientation);
+    }
+
+    /**
+     * Translates the line segment by a given vector (dX, dY) and returns a new line segment.
+     *
+     * @param dX Value of translation on X axis.
+     * @param dY Value of translation on Y axis.
+     * @return A new line segment translated by (dX, dY).
+     */
+    OrientedLineSegment translatedBy(double dX, double dY) const
+    {
+        return OrientedLineSegment(point1.translatedBy(dX, dY), point2.translatedBy(dX, dY), orientation);
+    }
+
+    /**
+     * Computes the distance from a point to the closest point of the segment.
+     *
+     * @param point The point.
+     * @return Distance between the point and the segment.
+     */
+    double distanceTo(const Point &point) const;
+};
+
+// Layouts match `EILPointValue`, `EILOrientedPointValue` and `EILOrientedLineSegmentValue` of the SDK, so arrays of
+// them can be handed over without copying.
+static_assert(std::is_trivially_copyable<Point>::value && sizeof(Point) == 2 * sizeof(double),
+              "Point must be layout-compatible with EILPointValue");
+static_assert(std::is_trivially_copyable<OrientedPoint>::value && sizeof(OrientedPoint) == 3 * sizeof(double),
+              "OrientedPoint must be layout-compatible with EILOrientedPointValue");
+static_assert(std::is_trivially_copyable<OrientedLineSegment>::value
+                  && sizeof(OrientedLineSegment) == 5 * sizeof(double),
+              "OrientedLineSegment must be layout-compatible with EILOrientedLineSegmentValue");
+
+/**
+ * Rotation around the origin followed by a translation. Distances and angles between shapes are preserved.
+ *
+ * Applying a transform costs a few multiplications; sine and cosine are computed once, when the transform is created.
+ */
+class RigidTransform
+{
+public:
+    /** Identity transform. */
+    RigidTransform() = default;
+
+    /**
+     * Creates a transform.
+     *
+     * @param dX Translation on X axis, applied after the rotation.
+     * @param dY Translation on Y axis, applied after the rotation.
+     * @param angle Angle of the rotation around the origin in degrees, counted clockwise like orientations.
+     */
+    RigidTransform(double dX, double dY, double angle = 0.0);
+
+    /** Transform rotating around a given center, like `Point::rotatedAround`. */
+    static RigidTransform rotationAround(const Point &center, double angle);
+
+    /** Translation on X axis. */
+    double dX() const { return _dX; }
+    /** Translation on Y axis. */
+    double dY() const { return _dY; }
+    /** Angle of the rotation in degrees, in the range [0, 360). */
+    double angle() const { return _angle; }
+
+    /** @return true if the transform only translates. */
+    bool isTranslation() const { return _angle == 0.0; }
+
+    /** Applies the transform to a point. */
+    Point apply(const Point &point) const
+    {
+        return Point(point.x * _cosine + point.y * _sine + _dX, point.y * _cosine - point.x * _sine + _dY);
+    }
+
+    /** @see apply. A defined orientation turns along and stays in the range [0, 360). */
+    OrientedPoint apply(const OrientedPoint &point) const
+    {
+        return OrientedPoint(apply(static_cast<const Point &>(point)), applyToOrientation(point.orientation));
+    }
+
+    /** Applies the transform to both end points. A defined orientation turns along. */
+    OrientedLineSegment apply(const OrientedLineSegment &segment) const
+    {
+        return OrientedLineSegment(apply(segment.point1), apply(segment.point2), applyToOrientation(segment.orientation));
+    }
+
+    /**
+     * Turns an orientation along with the transform.
+     *
+     * @param orientation Orientation in degrees, or `kOrientationUndefined`, which is returned unchanged.
+     * @return Orientation in the range [0, 360).
+     */
+    double applyToOrientation(double orientation) const;
+
+    /**
+     * Composes two transforms.
+     *
+     * @param next Transform applied after this one.
+     * @return Transform equal to applying this transform and then `next`.
+     */
+    RigidTransform followedBy(const RigidTransform &next) const;
+
+    /** @return Transform undoing this one. */
+    RigidTransform inverse() const;
+
+private:
+    double _dX = 0.0;
+    double _dY = 0.0;
+    double _angle = 0.0;
+    double _cosine = 1.0;
+    double _sine = 0.0;
+};
+
+/** Axis-aligned rectangle. Counterpart of `CGRect` as used by `EILLocation.boundingBox`. */
+struct Rect
+{
+    double minX = 0.0;
+    double minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+
+    double width() const { return maxX - minX; }
+    double height() const { return maxY - minY; }
+    bool contains(double x, double y) const { return x >= minX && x <= maxX && y >= minY && y <= maxY; }
+};
+
+/**
+ * Converts an orientation in degrees (counted clockwise from the [0, 1] vector) into a unit vector.
+ *
+ * @param orientation Orientation in degrees.
+ * @return Unit vector pointing in the direction of the orientation.
+ */
+Point directionForOrientation(double orientation);
+
+/**
+ * Converts a vector into an orientation in degrees counted clockwise from the [0, 1] vector.
+ *
+ * @param dX X component of the vector.
+ * @param dY Y component of the vector.
+ * @return Orientation in the range [0, 360).
+ */
+double orientationForDirection(double dX, double dY);
+
+} // namespace eil
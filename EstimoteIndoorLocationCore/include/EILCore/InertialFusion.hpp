@@ -0,0 +1,126 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/AtomicSnapshot.hpp"
+#include "EILCore/SensorSample.hpp"
+#include "EILCore/SpscRingBuffer.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace eil {
+
+/** Motion of the user derived from inertial sensors. */
+struct MotionState
+{
+    /**
+     * Time of the newest accelerometer sample the motion estimate is based on, on the clock of the samples. Zero if there
+     * was none yet. Other sensors do not advance it, so a stalled accelerometer makes the state look outdated.
+     */
+    double timestamp = 0.0;
+    /** Whether the user is walking. */
+    bool isMoving = false;
+    /** Estimated walking speed, in meters per second. */
+    double speed = 0.0;
+    /** Steps per second over the last few seconds. */
+    double stepFrequency = 0.0;
+    /** Number of steps detected since the start. */
+    uint64_t stepCount = 0;
+    /** Most recent atmospheric pressure in kilopascals, zero if no barometer sample arrived. */
+    double pressure = 0.0;
+};
+
+/**
+ * Fuses inertial sensor samples into the motion of the user on a dedicated thread. Backs the inertial positioning mode.
+ *
+ * Each sensor stream has its own single-producer single-consumer lock-free ring buffer, so sensor callbacks can push
+ * samples straight from the threads they are delivered on: pushing never blocks and never takes a lock, and bursts of
+ * sensor samples neither reach the thread processing beacon samples nor delay it. The fusion thread drains the buffers
+ * and publishes the result, which the positioning engine reads without locking at every update. Once all buffers are
+ * empty the fusion thread sleeps until the next sample arrives instead of polling.
+ *
+ * Walking is detected from peaks of the magnitude of user acceleration; speed follows from the step frequency.
+ */
+class InertialFusion
+{
+public:
+    /**
+     * Designated initializer. Starts the fusion thread, unless told not to.
+     *
+     * @param capacity Number of samples each sensor stream buffers; about ten seconds at 100 Hz by default.
+     * @param stepLength Average step length of the user, in meters.
+     * @param startThread Whether samples are processed on a fusion thread. Without one, `processPendingSamples` processes
+     *                    them on the calling thread, e.g. in step with the clock of a replayed trace.
+     */
+    explicit InertialFusion(size_t capacity = 1024, double stepLength = 0.7, bool startThread = true);
+
+    /** Processes the samples buffered so far, then stops the fusion thread. */
+    ~InertialFusion();
+
+    InertialFusion(const InertialFusion &) = delete;
+    InertialFusion &operator=(const InertialFusion &) = delete;
+
+    /**
+     * Hands a sensor sample over to the fusion thread. Lock-free and wait-free, except for the first sample after the
+     * fusion thread went idle, which briefly takes a lock to wake it up.
+     *
+     * Samples of one sensor type must always be pushed from the same thread, one at a time and in timestamp order.
+     * Different sensor types can be pushed from different threads.
+     *
+     * @param sample The sample.
+     * @return false if the buffer of the stream is full; the sample is dropped and counted in `droppedSampleCount`.
+     */
+    bool pushSample(const SensorSample &sample);
+
+    /**
+     * Processes the buffered samples on the calling thread and publishes the resulting motion. Only for fusions created
+     * without a fusion thread; must not be called concurrently with itself.
+     */
+    void processPendingSamples();
+
+    /** Most recent motion of the user. Lock-free; can be called from any thread. */
+    MotionState motionState() const { return _motionState.load(); }
+
+    /** Number of samples dropped because the fusion thread did not keep up. */
+    uint64_t droppedSampleCount() const { return _droppedSampleCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kStreamCount = 4;
+
+    void run();
+    bool drain();
+    /** Whether any stream holds a sample. */
+    bool hasPendingSamples() const;
+    /** Wakes the fusion thread if it is waiting for samples. */
+    void wakeUp();
+    void processAccelerometer(const SensorSample &sample);
+
+    std::array<std::unique_ptr<SpscRingBuffer<SensorSample>>, kStreamCount> _streams;
+    std::atomic<uint64_t> _droppedSampleCount{0};
+    std::atomic<bool> _stopping{false};
+    /** Set by the fusion thread before it waits for samples, cleared by whoever wakes it. */
+    std::atomic<bool> _idle{false};
+    std::mutex _wakeMutex;
+    std::condition_variable _wakeCondition;
+    AtomicSnapshot<MotionState> _motionState;
+
+    // Owned by the fusion thread.
+    double _stepLength;
+    MotionState _state;
+    double _filteredMagnitude = 0.0;
+    double _lastAccelerometerTimestamp = 0.0;
+    bool _aboveThreshold = false;
+    double _lastStepTimestamp = -1.0;
+    std::array<double, 8> _stepTimestamps{};
+    size_t _stepTimestampCount = 0;
+
+    std::thread _thread;
+};
+
+} // namespace eil
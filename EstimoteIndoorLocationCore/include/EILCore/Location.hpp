@@ -0,0 +1,260 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/BeaconSample.hpp"
+#include "EILCore/Geometry.hpp"
+#include "EILCore/PolygonIndex.hpp"
+#include "EILCore/PolygonSampler.hpp"
+#include "EILCore/Random.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eil {
+
+class NavigationGraph;
+class PinIndex;
+class SegmentIndex;
+
+/** Represents a beacon with additional information about its position. Counterpart of `EILPositionedBeacon`. */
+struct PositionedBeacon
+{
+    /** Beacons identifier (MAC address or identifier). */
+    std::string identifier;
+    /** Compact identifier derived from `identifier`. */
+    BeaconId beacon = 0;
+    /** Oriented point representing beacons position and orientation. */
+    OrientedPoint position;
+    /** Beacons proximity UUID. Empty, if unknown. */
+    std::string proximityUUID;
+    /** Beacons major value. Negative, if unknown. */
+    int major = -1;
+    /** Beacons minor value. Negative, if unknown. */
+    int minor = -1;
+
+    PositionedBeacon() = default;
+    PositionedBeacon(std::string identifier, const OrientedPoint &position)
+        : identifier(std::move(identifier)), beacon(beaconIdFromIdentifier(this->identifier)), position(position) {}
+};
+
+/** Describes the type of the linear object. Counterpart of `EILLocationLinearObjectType`. */
+enum class LinearObjectType
+{
+    Door,
+    Window,
+};
+
+/** Represents an object in a location which position can be described by a line segment. Counterpart of `EILLocationLinearObject`. */
+struct LinearObject
+{
+    /** Type of the object. */
+    LinearObjectType type = LinearObjectType::Door;
+    /** Coordinates of the object in form of an oriented line segment. */
+    OrientedLineSegment position;
+};
+
+/** Represents a physical object inside location like landmarks or points of interests. Counterpart of `EILLocationPin`. */
+struct LocationPin
+{
+    /** Name of the location pin. */
+    std::string name;
+    /** Type of the location pin. */
+    std::string type;
+    /** Identifier of the location pin. Negative, if the pin was not saved in Estimote Cloud. */
+    int64_t identifier = -1;
+    /** Position of the pin inside a location. */
+    OrientedPoint position;
+};
+
+/**
+ * Represents a physical location prepared for Estimote Indoor Location. Counterpart of `EILLocation`. Object is immutable.
+ *
+ * Locations are shared between engines as `LocationRef`. Instances can be created by `LocationBuilder`.
+ */
+class Location
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param identifier Globally unique identifier of the location. Can be empty for locations not persisted in Estimote Cloud.
+     * @param name Name of the location.
+     * @param boundarySegments Boundary of the location. Segments have to form a closed polygon.
+     * @param beacons Beacons located in the location.
+     * @param linearObjects Linear objects inside the location.
+     * @param locationPins Location pins that belong to location.
+     * @param orientation Orientation to magnetic north, counted clockwise. Value is in degrees.
+     */
+    Location(std::string identifier,
+             std::string name,
+             std::vector<OrientedLineSegment> boundarySegments,
+             std::vector<PositionedBeacon> beacons,
+             std::vector<LinearObject> linearObjects = std::vector<LinearObject>(),
+             std::vector<LocationPin> locationPins = std::vector<LocationPin>(),
+             double orientation = 0.0);
+
+    /** Globally unique identifier of the location. */
+    const std::string &identifier() const { return _identifier; }
+
+    /** Name of the location. */
+    const std::string &name() const { return _name; }
+
+    /** Boundary of the location. */
+    const std::vector<OrientedLineSegment> &boundarySegments() const { return _boundarySegments; }
+
+    /** Beacons located in the location. */
+    const std::vector<PositionedBeacon> &beacons() const { return _beacons; }
+
+    /** Linear objects inside the location. */
+    const std::vector<LinearObject> &linearObjects() const { return _linearObjects; }
+
+    /** Location pins that belong to location. */
+    const std::vector<LocationPin> &locationPins() const { return _locationPins; }
+
+    /** Orientation to magnetic north, counted clockwise. Value is in degrees. */
+    double orientation() const { return _orientation; }
+
+    /** Polygon of shape of the location. Points are sorted clockwise. Built on first use. Thread-safe. */
+    const std::vector<Point> &polygon() const;
+
+    /** Area of the location in square meters. Computed on first use. Thread-safe. */
+    double area() const;
+
+    /** Bounding box of the location. Computed on first use. Thread-safe. */
+    const Rect &boundingBox() const;
+
+    /**
+     * Finds index of the beacon in `beacons`.
+     *
+     * @param beacon Compact beacon identifier.
+     * @return Index of the beacon or a negative value if the beacon does not belong to the location.
+     */
+    int indexOfBeacon(BeaconId beacon) const;
+
+    /**
+     * Checks if a given point is inside the location.
+     *
+     * @param x X coordinate.
+     * @param y Y coordinate.
+     * @return true if given point is inside the location.
+     */
+    bool containsPoint(double x, double y) const { return polygonIndex().containsPoint(x, y); }
+
+    /** @see containsPoint */
+    bool containsPoint(const Point &point) const { return containsPoint(point.x, point.y); }
+
+    /**
+     * Checks a batch of points at once.
+     *
+     * @param points Points to check.
+     * @param count Number of points.
+     * @param results Receives for each point whether it is inside the location. Must hold `count` elements.
+     */
+    void containsPoints(const Point *points, size_t count, bool *results) const
+    {
+        polygonIndex().containsPoints(points, count, results);
+    }
+
+    /**
+     * Acceleration structure behind `containsPoint`, built on first use. Thread-safe.
+     *
+     * Fetch it once before testing many points in a loop.
+     */
+    const PolygonIndex &polygonIndex() const;
+
+    /**
+     * Returns an equally distributed random point inside the location.
+     *
+     * @param random Source of randomness. Seed it to get a reproducible sequence of points.
+     * @return A random point inside the location.
+     */
+    Point randomPointInside(Random &random) const;
+
+    /**
+     * Fills a buffer with equally distributed random points inside the location, in constant time per point.
+     *
+     * @param random Source of randomness. The points equal those of `count` consecutive calls to `randomPointInside`.
+     * @param points Buffer receiving the points. Must hold `count` elements.
+     * @param count Number of points to draw.
+     */
+    void randomPointsInside(Random &random, Point *points, size_t count) const;
+
+    /** Area-weighted triangulation behind `randomPointsInside`, built on first use. Thread-safe. */
+    const PolygonSampler &polygonSampler() const;
+
+    /**
+     * Bounding volume hierarchy over walls, doors and windows, built on first use. Thread-safe.
+     *
+     * Answers distance-to-wall and nearest segment queries, for single points and batches.
+     */
+    const SegmentIndex &segmentIndex() const;
+
+    /**
+     * k-d tree over location pins, built on first use. Thread-safe.
+     *
+     * Answers nearest pin and radius queries, optionally filtered by pin type.
+     */
+    const PinIndex &pinIndex() const;
+
+    /**
+     * Visibility graph for routing between points and to pins, built on first use with the default clearance.
+     * Thread-safe.
+     */
+    const NavigationGraph &navigationGraph() const;
+
+    /**
+     * Filters this location linear objects and returns only those for given type.
+     *
+     * Objects are grouped by type once, on first use; later calls only look the group up. Thread-safe.
+     *
+     * @param type Type of linear object to filter this location linear objects.
+     * @return Linear objects with given type, in the order of `linearObjects`.
+     */
+    const std::vector<LinearObject> &linearObjectsWithType(LinearObjectType type) const;
+
+    /**
+     * Translates the location by a given vector (dX, dY) and returns a new location.
+     *
+     * @param dX Value of the translation on X axis.
+     * @param dY Value of the translation on Y axis.
+     * @return A new location translated by (dX, dY).
+     */
+    Location translatedBy(double dX, double dY) const;
+
+    /**
+     * Rotates and translates the location and returns a new location.
+     *
+     * Copies every beacon, linear object and pin. Use `TransformedLocation` for a view that shares them instead.
+     *
+     * @param transform Transform applied to all geometry. The orientation to magnetic north is corrected by its angle.
+     * @return A new, transformed location.
+     */
+    Location transformedBy(const RigidTransform &transform) const;
+
+private:
+    std::string _identifier;
+    std::string _name;
+    std::vector<OrientedLineSegment> _boundarySegments;
+    std::vector<PositionedBeacon> _beacons;
+    std::vector<LinearObject> _linearObjects;
+    std::vector<LocationPin> _locationPins;
+    double _orientation;
+
+    std::unordered_map<BeaconId, int> _beaconIndices;
+
+    struct DerivedGeometry;
+    // Built on first use and shared by copies of the location, which have the same geometry.
+    std::shared_ptr<DerivedGeometry> _derivedGeometry;
+
+    /** Derived geometry with the polygon, bounding box and area computed. */
+    const DerivedGeometry &shape() const;
+};
+
+/** Shared, immutable reference to a location. */
+typedef std::shared_ptr<const Location> LocationRef;
+
+} // namespace eil
@@ -0,0 +1,147 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Location.hpp"
+
+#include <string>
+#include <vector>
+
+namespace eil {
+
+/** Side of the boundary segment as seen from inside of the location. Counterpart of `EILLocationBuilderSide`. */
+enum class LocationBuilderSide
+{
+    /** Left side of the boundary segment as seen from inside of the location. */
+    Left,
+    /** Right side of the boundary segment as seen from inside of the location. */
+    Right,
+};
+
+/**
+ * Builder object for creating `Location` objects. Counterpart of `EILLocationBuilder`.
+ *
+ * The shape of the location is defined by its boundary points. Points that define shape of location also define
+ * its boundary segments. They are indexed in the same order as the points.
+ */
+class LocationBuilder
+{
+public:
+    /**
+     * Adds a list of boundary points of location. Can be added clockwise or counter clockwise.
+     *
+     * @param boundaryPoints List of boundary points that defines a location.
+     */
+    void setLocationBoundaryPoints(const std::vector<Point> &boundaryPoints);
+
+    /**
+     * Sets the orientation of the room with respect to the magnetic north. Counted clockwise in degrees.
+     *
+     * @param orientation Location orientation in degrees.
+     */
+    void setLocationOrientation(double orientation) { _orientation = orientation; }
+
+    /**
+     * Places a beacon on the boundary segment.
+     *
+     * @param identifier Beacon identifier (MAC address or identifier).
+     * @param boundarySegmentIndex Index of the boundary segment.
+     * @param distance Distance from the beacon to the side of the boundary segment.
+     * @param side Side of the boundary segment as seen from inside of the location.
+     */
+    void addBeacon(const std::string &identifier, size_t boundarySegmentIndex, double distance, LocationBuilderSide side);
+
+    /**
+     * Places a beacon in the location.
+     *
+     * @param identifier Beacon identifier (MAC address or identifier).
+     * @param position Coordinates of the beacon position.
+     */
+    void addBeacon(const std::string &identifier, const OrientedPoint &position);
+
+    /**
+     * Adds a location pin in the location.
+     *
+     * @param name Pin name.
+     * @param type Pin type.
+     * @param position Pin position.
+     */
+    void addLocationPin(const std::string &name, const std::string &type, const OrientedPoint &position);
+
+    /**
+     * Places a door on the boundary segment.
+     *
+     * @param length Length of the door.
+     * @param boundarySegmentIndex Index of the boundary segment.
+     * @param distance Distance from the door to the side of the boundary segment.
+     * @param side Side of the boundary segment as seen from inside of the location.
+     */
+    void addDoor(double length, size_t boundarySegmentIndex, double distance, LocationBuilderSide side);
+
+    /**
+     * Places a window on the boundary segment.
+     *
+     * @param length Length of the window.
+     * @param boundarySegmentIndex Index of the boundary segment.
+     * @param distance Distance from the window to the side of the boundary segment.
+     * @param side Side of the boundary segment as seen from inside of the location.
+     */
+    void addWindow(double length, size_t boundarySegmentIndex, double distance, LocationBuilderSide side);
+
+    /**
+     * Sets a name of the location. If not set `kLocationDefaultName` is used.
+     *
+     * @param name Name of the location.
+     */
+    void setLocationName(const std::string &name) { _name = name; }
+
+    /**
+     * Sets an identifier of the location. Locations built locally have no identifier unless set explicitly.
+     *
+     * @param identifier Identifier of the location.
+     */
+    void setLocationIdentifier(const std::string &identifier) { _identifier = identifier; }
+
+    /**
+     * Builds a location.
+     *
+     * @return A valid location or `nullptr` if the boundary has less than 3 points or any object was placed on a non-existing boundary segment.
+     */
+    LocationRef build() const;
+
+private:
+    struct SegmentPlacement
+    {
+        size_t boundarySegmentIndex;
+        double distance;
+        double length;
+        LocationBuilderSide side;
+    };
+
+    struct PlacedBeacon
+    {
+        std::string identifier;
+        bool onBoundary;
+        SegmentPlacement placement;
+        OrientedPoint position;
+    };
+
+    struct PlacedLinearObject
+    {
+        LinearObjectType type;
+        SegmentPlacement placement;
+    };
+
+    std::vector<Point> _boundaryPoints;
+    double _orientation = 0.0;
+    std::string _name;
+    std::string _identifier;
+    std::vector<PlacedBeacon> _beacons;
+    std::vector<PlacedLinearObject> _linearObjects;
+    std::vector<LocationPin> _locationPins;
+};
+
+/** Name of the location built without explicitly setting it. Mirrors `EIL_LOCATION_DEFAULT_NAME`. */
+extern const char *const kLocationDefaultName;
+
+} // namespace eil
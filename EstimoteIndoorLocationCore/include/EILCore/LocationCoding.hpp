@@ -0,0 +1,46 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Location.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace eil {
+
+/**
+ * Serializes the location into a compact binary representation.
+ *
+ * The representation is stable across platforms, so it can be written on a phone and read on a server.
+ *
+ * @param location The location.
+ * @return Binary representation of the location.
+ */
+std::string encodeLocation(const Location &location);
+
+/**
+ * Deserializes a location from its binary representation.
+ *
+ * @param bytes Binary representation created by `encodeLocation`.
+ * @param length Length of the representation in bytes.
+ * @return A location or `nullptr` if the representation is malformed.
+ */
+LocationRef decodeLocation(const uint8_t *bytes, size_t length);
+
+/**
+ * Computes a fingerprint of the location content. Locations with equal geometry, beacons and objects have equal
+ * fingerprints, so state saved for a location can be checked against the location it is applied to.
+ *
+ * @param location The location.
+ * @return 64-bit hash of the binary representation of the location.
+ */
+uint64_t locationFingerprint(const Location &location);
+
+/** @see decodeLocation */
+inline LocationRef decodeLocation(const std::string &data)
+{
+    return decodeLocation(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+}
+
+} // namespace eil
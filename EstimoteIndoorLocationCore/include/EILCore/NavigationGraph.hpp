@@ -0,0 +1,204 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Geometry.hpp"
+#include "EILCore/Location.hpp"
+#include "EILCore/SegmentIndex.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace eil {
+
+/** Shortest walkable path between two points. */
+struct Route
+{
+    /** Points of the path, from the start to the destination, both included. Empty if there is no path. */
+    std::vector<Point> waypoints;
+    /** Length of the path in meters. Infinite if there is no path. */
+    double length = std::numeric_limits<double>::infinity();
+
+    /** @return true if a path was found. */
+    bool found() const { return !waypoints.empty(); }
+};
+
+class NavigationGraph;
+
+/**
+ * Shortest walkable distances from every node of a `NavigationGraph` to one destination.
+ *
+ * Computed once by Dijkstra's algorithm from the destination. Afterwards the distance and the route from any point
+ * take a sort of the nodes by their lower bound and usually one or two visibility checks. Immutable; can be shared
+ * between threads. Shares the node positions and the wall index with its graph and keeps them alive, so it stays
+ * valid after the graph and its location are gone.
+ */
+class DistanceField
+{
+public:
+    /** Destination of the field. */
+    const Point &destination() const { return _destination; }
+
+    /**
+     * Computes the walking distance from a point to the destination.
+     *
+     * @param from Start point inside the location.
+     * @return Length of the shortest path, infinite if the destination cannot be reached.
+     */
+    double distanceFrom(const Point &from) const;
+
+    /**
+     * Finds the shortest path from a point to the destination.
+     *
+     * @param from Start point inside the location.
+     * @param route Receives the path. Previous contents are replaced.
+     * @return true if the destination can be reached.
+     */
+    bool routeFrom(const Point &from, Route &route) const;
+
+private:
+    friend class NavigationGraph;
+
+    /** Runs Dijkstra's algorithm over the edges of the graph, which are not needed afterwards. */
+    DistanceField(const NavigationGraph &graph, const Point &destination);
+
+    /**
+     * Finds the first node on the shortest path from a point.
+     *
+     * @return Index of the node, -1 if the destination is in straight sight, -2 if it cannot be reached.
+     */
+    int firstNode(const Point &from, double &length) const;
+
+    /** Whether a straight line between two points crosses no wall. */
+    bool isVisible(const Point &a, const Point &b) const { return !_walls->intersects(a, b, kWallSegments); }
+
+    std::shared_ptr<const SegmentIndex> _walls;
+    std::shared_ptr<const std::vector<Point>> _nodes;
+    Point _destination;
+    /** Distance from each node to the destination, infinite if unreachable. */
+    std::vector<double> _distances;
+    /** Next node on the way from each node to the destination, -1 if the destination is in straight sight. */
+    std::vector<int> _nextNodes;
+};
+
+/**
+ * Visibility graph of a location for indoor routing.
+ *
+ * Shortest paths inside a polygon bend only at its reflex corners. Nodes of the graph are those corners, moved into the
+ * location by the wall clearance so that routes do not graze walls. Nodes are connected if a straight walk between them
+ * does not touch a wall, which is checked against a `SegmentIndex` of the walls. Routes between arbitrary points are
+ * found with A*, with the straight-line distance as the heuristic.
+ *
+ * Repeated routing to the same destination, such as rerouting to a pin on every position update, uses cached
+ * `DistanceField`s instead. Fields of the most recently used pins are kept, up to a fixed number.
+ *
+ * Thread-safe. The graph copies the geometry it needs and does not refer to the location after it is built.
+ */
+class NavigationGraph
+{
+public:
+    /** Default distance between routes and wall corners, in meters. */
+    static constexpr double kDefaultClearance = 0.3;
+
+    /** Number of pin distance fields kept by `routeToPin` and `distanceToPin`. */
+    static constexpr size_t kMaximumCachedPinFields = 32;
+
+    /**
+     * Builds the graph. Takes time quadratic in the number of reflex corners.
+     *
+     * @param location Location to route in.
+     * @param clearance Distance between routes and wall corners, in meters.
+     */
+    explicit NavigationGraph(const Location &location, double clearance = kDefaultClearance);
+
+    NavigationGraph(const NavigationGraph &) = delete;
+    NavigationGraph &operator=(const NavigationGraph &) = delete;
+
+    /** Number of nodes. */
+    size_t nodeCount() const { return _nodes->size(); }
+
+    /** Number of edges, each counted once. */
+    size_t edgeCount() const { return _edgeTargets.size() / 2; }
+
+    /** Position of the node at a given index. */
+    const Point &node(size_t index) const { return (*_nodes)[index]; }
+
+    /**
+     * Checks if a straight walk between two points does not touch any wall.
+     *
+     * @param a First point.
+     * @param b Second point.
+     * @return true if the line segment between the points does not touch a boundary segment.
+     */
+    bool isVisible(const Point &a, const Point &b) const { return !_walls->intersects(a, b, kWallSegments); }
+
+    /**
+     * Finds the shortest path between two points with A*.
+     *
+     * @param from Start point inside the location.
+     * @param to Destination inside the location.
+     * @param route Receives the path. Previous contents are replaced.
+     * @return true if the destination can be reached.
+     */
+    bool findRoute(const Point &from, const Point &to, Route &route) const;
+
+    /**
+     * Computes shortest distances from every node to a destination, for many queries towards it.
+     *
+     * @param destination Destination inside the location.
+     * @return Distance field of the destination.
+     */
+    std::shared_ptr<const DistanceField> distanceFieldTo(const Point &destination) const;
+
+    /**
+     * Finds the shortest path from a point to a pin, through the cached distance field of the pin.
+     *
+     * @param from Start point inside the location.
+     * @param pinIndex Index of the pin in `Location::locationPins`.
+     * @param route Receives the path. Previous contents are replaced.
+     * @return true if the pin exists and can be reached.
+     */
+    bool routeToPin(const Point &from, size_t pinIndex, Route &route) const;
+
+    /**
+     * Computes the walking distance from a point to a pin, through the cached distance field of the pin.
+     *
+     * @param from Start point inside the location.
+     * @param pinIndex Index of the pin in `Location::locationPins`.
+     * @return Length of the shortest path, infinite if the pin does not exist or cannot be reached.
+     */
+    double distanceToPin(const Point &from, size_t pinIndex) const;
+
+    /**
+     * Returns the cached distance field of a pin, computing it if needed.
+     *
+     * @param pinIndex Index of the pin in `Location::locationPins`.
+     * @return Distance field of the pin, nullptr if there is no such pin.
+     */
+    std::shared_ptr<const DistanceField> pinDistanceField(size_t pinIndex) const;
+
+private:
+    friend class DistanceField;
+
+    // Shared with the distance fields, which may outlive the graph.
+    std::shared_ptr<const SegmentIndex> _walls;
+    std::shared_ptr<const std::vector<Point>> _nodes;
+    /** Neighbours of each node, node after node; the neighbours of node i start at `_edgeOffsets[i]`. */
+    std::vector<uint32_t> _edgeOffsets;
+    std::vector<uint32_t> _edgeTargets;
+    std::vector<double> _edgeLengths;
+    std::vector<Point> _pins;
+
+    /** Most recently used pin fields first. */
+    mutable std::mutex _pinFieldsMutex;
+    mutable std::list<std::pair<size_t, std::shared_ptr<const DistanceField>>> _pinFields;
+    mutable std::unordered_map<size_t, decltype(_pinFields)::iterator> _pinFieldsByPin;
+};
+
+} // namespace eil
@@ -0,0 +1,143 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/AlgorithmParameters.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace eil {
+
+/**
+ * Reads algorithm parameters from their JSON representation, a flat object keyed by the names of the fields of
+ * `AlgorithmParameters`, e.g. `{"revision": 3, "measuredPower": -70.5, "particleCount": 500}`.
+ *
+ * Missing keys keep the values already in `parameters`; unknown keys are skipped, so newer revisions stay readable.
+ * `randomSeed` is never read, it is a property of the device rather than of the beacons.
+ *
+ * @param json JSON representation.
+ * @param parameters Parameters to update. Left untouched if the representation is malformed or a value is out of range.
+ * @param revision Receives the value of the `revision` key, zero if there is none.
+ * @return false if the representation is malformed or a value is out of range.
+ */
+bool decodeAlgorithmParameters(const std::string &json, AlgorithmParameters &parameters, int64_t &revision);
+
+/**
+ * Writes algorithm parameters as JSON readable by `decodeAlgorithmParameters`, e.g. to prepare a parameter bundle.
+ *
+ * @param parameters The parameters.
+ * @param revision Revision to write, omitted if zero.
+ * @return JSON representation on a single line.
+ */
+std::string encodeAlgorithmParameters(const AlgorithmParameters &parameters, int64_t revision = 0);
+
+/** Conditional request for the latest parameters. */
+struct ParameterRequest
+{
+    /** URL of the parameters. */
+    std::string url;
+    /** Value for the `If-None-Match` header, empty if it should not be sent. */
+    std::string ifNoneMatch;
+    /** Value for the `If-Modified-Since` header, empty if it should not be sent. */
+    std::string ifModifiedSince;
+};
+
+/** Response to a `ParameterRequest`. */
+struct ParameterResponse
+{
+    /** HTTP status code, zero if the request failed before a response arrived. */
+    int statusCode = 0;
+    /** Body of the response, the parameters as JSON for status 200. */
+    std::string body;
+    /** Value of the `ETag` header, empty if there was none. */
+    std::string etag;
+    /** Value of the `Last-Modified` header, empty if there was none. */
+    std::string lastModified;
+};
+
+/** Where the current parameters of a `ParameterStore` come from. */
+enum class ParameterSource
+{
+    /** Built-in defaults of `AlgorithmParameters`. */
+    Defaults,
+    /** Bundle shipped with the app. */
+    Bundle,
+    /** On-disk cache of an earlier fetch. */
+    Cache,
+    /** Fetch during this run. */
+    Network,
+};
+
+/**
+ * Keeps the positioning algorithm parameters up to date without ever blocking on the network.
+ *
+ * Parameters are available right away from the on-disk cache of the last fetch, or from a bundle shipped with the app,
+ * whichever has the newer revision, and fall back to the built-in defaults. `refresh` revalidates them in the background
+ * with `If-None-Match` and `If-Modified-Since`, so nothing is downloaded when nothing changed. The request is carried
+ * out by a transport provided by the platform layer, e.g. `NSURLSession` on iOS.
+ *
+ * Engines take their parameters when they are created, so refreshed parameters apply to the next engine.
+ * Thread-safe; the transport may complete on any thread, also after the store has been destroyed.
+ */
+class ParameterStore
+{
+public:
+    /** Block invoked with the response to a request. Must be invoked exactly once. */
+    typedef std::function<void(const ParameterResponse &response)> ResponseHandler;
+
+    /** Block performing a request, synchronously or asynchronously. */
+    typedef std::function<void(const ParameterRequest &request, ResponseHandler completion)> Transport;
+
+    /**
+     * Designated initializer. Loads the cache, which is a small local file, right away.
+     *
+     * @param url URL of the parameters.
+     * @param cachePath Path of the cache file. Its directory has to exist.
+     * @param transport Block performing requests.
+     */
+    ParameterStore(std::string url, std::string cachePath, Transport transport);
+
+    ParameterStore(const ParameterStore &) = delete;
+    ParameterStore &operator=(const ParameterStore &) = delete;
+
+    /**
+     * Reads a parameter bundle shipped with the app. It is used unless the cache holds a newer revision.
+     *
+     * @param path Path of a JSON file readable by `decodeAlgorithmParameters`.
+     * @return false if the bundle cannot be read or is malformed.
+     */
+    bool loadBundle(const std::string &path);
+
+    /** Current parameters. Never blocks on the network. */
+    AlgorithmParameters parameters() const;
+
+    /** Revision of the current parameters, zero for the defaults or if it is unknown. */
+    int64_t revision() const;
+
+    /** Where the current parameters come from. */
+    ParameterSource source() const;
+
+    /**
+     * Revalidates the parameters. Does nothing but invoke the completion if a refresh is already in progress.
+     *
+     * @param completion Block invoked, on the thread the transport completes on, with true if the parameters changed.
+     *                   Can be empty.
+     */
+    void refresh(std::function<void(bool changed)> completion = nullptr);
+
+private:
+    struct State;
+
+    static void handleResponse(const std::shared_ptr<State> &state, const ParameterResponse &response,
+                               const std::function<void(bool changed)> &completion);
+
+    std::string _url;
+    Transport _transport;
+    // Shared with pending requests, so a late response never touches a destroyed store.
+    std::shared_ptr<State> _state;
+};
+
+} // namespace eil
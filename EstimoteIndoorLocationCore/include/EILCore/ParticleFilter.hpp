@@ -0,0 +1,134 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/AlgorithmParameters.hpp"
+#include "EILCore/BeaconFilterBank.hpp"
+#include "EILCore/Location.hpp"
+#include "EILCore/PositionUpdate.hpp"
+#include "EILCore/Random.hpp"
+#include "EILCore/SignalMap.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace eil {
+
+struct MotionState;
+
+/** Single weighted hypothesis of the position of the user. */
+struct Particle
+{
+    double x = 0.0;
+    double y = 0.0;
+    double weight = 0.0;
+};
+
+/**
+ * Particle filter estimating the position of the user inside a single location.
+ *
+ * The filter does not consume beacon samples directly. It reads smoothed signal statistics from a `BeaconFilterBank`,
+ * which allows a single bank to be shared by filters of several locations.
+ * Not thread-safe; all calls have to be serialized by the owner.
+ */
+class ParticleFilter
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param location The location within which the user is positioned.
+     * @param parameters Parameters of the positioning algorithm.
+     */
+    ParticleFilter(LocationRef location, const AlgorithmParameters &parameters);
+
+    /**
+     * Discards the current estimate. The next step will spread particles over the whole location again.
+     * With `AlgorithmParameters::randomSeed` set, the random stream starts over as well.
+     */
+    void reset();
+
+    /**
+     * Runs a single predict-correct-resample cycle.
+     *
+     * @param timestamp Time of the step.
+     * @param beacons Smoothed beacon statistics.
+     * @param motion Motion of the user from inertial sensors, or `nullptr` to assume any speed up to
+     *               `AlgorithmParameters::maxWalkingSpeed`.
+     * @return Number of beacons used to correct the estimate. If zero, the step was skipped.
+     */
+    int step(double timestamp, const BeaconFilterBank &beacons, const MotionState *motion = nullptr);
+
+    /** Whether particles were spread over the location. */
+    bool isInitialized() const { return _initialized; }
+
+    /**
+     * Computes the current estimate. Orientation is left undefined.
+     *
+     * @return Position update for the time of the last step.
+     */
+    PositionUpdate estimate() const;
+
+    /** The location within which the user is positioned. */
+    const LocationRef &location() const { return _location; }
+
+    /**
+     * Sets a precomputed signal map used instead of evaluating the signal model for every particle.
+     *
+     * @param map Map computed for the location and the parameters of the filter, or `nullptr` to evaluate the model directly.
+     */
+    void setSignalMap(SignalMapRef map);
+
+    /** The precomputed signal map in use, `nullptr` if the signal model is evaluated directly. */
+    const SignalMapRef &signalMap() const { return _signalMap; }
+
+    /** Time of the last step that corrected the estimate. */
+    double lastTimestamp() const { return _lastTimestamp; }
+
+    /**
+     * Copies the current particles out of the filter.
+     *
+     * @return Particles of the filter, empty if the filter is not initialized.
+     */
+    std::vector<Particle> particles() const;
+
+    /**
+     * Replaces the estimate with previously saved particles. Particles outside of the location are dropped.
+     *
+     * @param particles Particles saved with `particles`.
+     * @param timestamp Time of the step the particles were saved after. The next step moves them by the time elapsed since.
+     * @return true if any particle was restored, false if the filter was left untouched.
+     */
+    bool restoreParticles(const std::vector<Particle> &particles, double timestamp);
+
+private:
+    /** Seeds `_random` from `AlgorithmParameters::randomSeed` and the location, if a seed is set. */
+    void seedRandom();
+    void initialize();
+    void selectBeacons(double timestamp, const BeaconFilterBank &beacons);
+    void predict(double elapsed, const MotionState *motion);
+    void correct(const std::vector<int> &beaconIndices, const std::vector<double> &rssis);
+    void resampleIfNeeded();
+
+    LocationRef _location;
+    AlgorithmParameters _parameters;
+    Random _random;
+    SignalMapRef _signalMap;
+
+    bool _initialized = false;
+    double _lastTimestamp = 0.0;
+
+    std::vector<double> _xs;
+    std::vector<double> _ys;
+    std::vector<double> _weights;
+
+    // Scratch buffers reused between steps to keep the hot path allocation free.
+    std::vector<double> _logWeights;
+    std::vector<int> _beaconIndices;
+    std::vector<double> _rssis;
+    std::vector<std::pair<double, int>> _candidates;
+    std::vector<double> _resampledXs;
+    std::vector<double> _resampledYs;
+};
+
+} // namespace eil
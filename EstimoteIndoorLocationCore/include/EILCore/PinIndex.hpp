@@ -0,0 +1,101 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Geometry.hpp"
+#include "EILCore/Location.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eil {
+
+/** Result of a pin query. */
+struct PinHit
+{
+    /** Index of the pin in `Location::locationPins`. */
+    size_t index = 0;
+    /** Distance between the queried point and the pin. */
+    double distance = 0.0;
+};
+
+/**
+ * k-d tree over the pins of a location, for nearest pin and radius queries.
+ *
+ * Pins are stored in tree order in one flat array, with the median of every range splitting it along the wider axis.
+ * Every node also remembers which pin types occur below it, so queries filtered by type skip subtrees without pins of
+ * that type. A query visits O(log n + k) pins instead of all of them.
+ *
+ * Results are sorted by distance; pins at equal distance are sorted by index. Output vectors are reused, so queries
+ * repeated on every position update do not allocate once the vectors have grown. Immutable once built; can be used
+ * from any number of threads.
+ */
+class PinIndex
+{
+public:
+    /**
+     * Builds the index.
+     *
+     * @param location Location whose pins are indexed.
+     */
+    explicit PinIndex(const Location &location);
+
+    /** Number of indexed pins. */
+    size_t pinCount() const { return _pins.size(); }
+
+    /**
+     * Finds pins closest to a point.
+     *
+     * @param point The point.
+     * @param count Maximum number of pins to find.
+     * @param hits Receives up to `count` closest pins, nearest first. Previous contents are replaced.
+     * @param type Type of pins to consider. Empty to consider all pins.
+     */
+    void pinsNearestToPoint(const Point &point, size_t count, std::vector<PinHit> &hits,
+                            const std::string &type = std::string()) const;
+
+    /**
+     * Finds pins within a distance from a point.
+     *
+     * @param radius Maximum distance in meters, inclusive.
+     * @param point The point.
+     * @param hits Receives all pins within the radius, nearest first. Previous contents are replaced.
+     * @param type Type of pins to consider. Empty to consider all pins.
+     */
+    void pinsWithinRadius(double radius, const Point &point, std::vector<PinHit> &hits,
+                          const std::string &type = std::string()) const;
+
+private:
+    /** Pin in tree order. The median of every range of the array is the node splitting that range. */
+    struct Node
+    {
+        Point position;
+        uint32_t index;
+        /** Whether the range of this node is split by x rather than y. */
+        bool splitX;
+        /** Index of the type of the pin in `_typeIds`. */
+        uint32_t typeId;
+        /** Union of the bits of the pin types in the range of this node. */
+        uint64_t subtreeTypes;
+    };
+
+    /** Query state shared by the recursive search. */
+    struct Search;
+
+    /** Sets up the type filter of a search. Returns false if no pin has the type. */
+    bool filterByType(Search &query, const std::string &type) const;
+
+    /** Sorts the range [begin, end) of `_pins` into a subtree. Returns the union of its type bits. */
+    uint64_t build(uint32_t begin, uint32_t end);
+
+    void search(Search &query, uint32_t begin, uint32_t end) const;
+
+    std::vector<Node> _pins;
+    /** Index of each pin type. */
+    std::unordered_map<std::string, uint32_t> _typeIds;
+};
+
+} // namespace eil
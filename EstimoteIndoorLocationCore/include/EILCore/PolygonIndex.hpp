@@ -0,0 +1,122 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Geometry.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eil {
+
+/**
+ * Acceleration structure for point-in-polygon tests of a fixed polygon.
+ *
+ * The bounding box is divided into a uniform grid with several cells per vertex. Each cell is classified as inside,
+ * outside or crossed by the boundary. Most points fall into inside or outside cells and are answered by a single
+ * lookup. For a boundary cell, the crossings of a ray cast to the right are split. Edges that the ray crosses from
+ * anywhere in the cell are counted in advance. Only the few edges near the cell are tested per point. Results are
+ * identical to the plain even-odd test over all edges.
+ *
+ * Immutable once built; can be used from any number of threads.
+ */
+class PolygonIndex
+{
+public:
+    /**
+     * Builds the index.
+     *
+     * @param polygon Vertices of the polygon. Small polygons are tested directly, without a grid.
+     */
+    explicit PolygonIndex(std::vector<Point> polygon);
+
+    /**
+     * Checks if a given point is inside the polygon.
+     *
+     * @param x X coordinate.
+     * @param y Y coordinate.
+     * @return true if given point is inside the polygon.
+     */
+    bool containsPoint(double x, double y) const
+    {
+        if (!_boundingBox.contains(x, y))
+        {
+            return false;
+        }
+        if (_cells.empty())
+        {
+            return containsPointInEdges(x, y, _edges.data(), _edges.size());
+        }
+
+        size_t column = std::min(static_cast<size_t>((x - _boundingBox.minX) * _inverseCellWidth), _columnCount - 1);
+        size_t row = std::min(static_cast<size_t>((y - _boundingBox.minY) * _inverseCellHeight), _rowCount - 1);
+        size_t index = row * _columnCount + column;
+        uint8_t cell = _cells[index];
+        if (cell < kBoundaryCell)
+        {
+            return cell == kInsideCell;
+        }
+        bool crossedAnyway = cell == kBoundaryCellCrossed;
+        return crossedAnyway != containsPointInEdges(x, y, _edges.data() + _edgeOffsets[index],
+                                                     _edgeOffsets[index + 1] - _edgeOffsets[index]);
+    }
+
+    /**
+     * Checks a batch of points.
+     *
+     * @param points Points to check.
+     * @param count Number of points.
+     * @param results Receives for each point whether it is inside the polygon. Must hold `count` elements.
+     */
+    void containsPoints(const Point *points, size_t count, bool *results) const;
+
+    /** Number of grid cells, zero if the polygon is tested directly. */
+    size_t cellCount() const { return _cells.size(); }
+
+private:
+    static constexpr uint8_t kOutsideCell = 0;
+    static constexpr uint8_t kInsideCell = 1;
+    /** Boundary cells, with an even or odd number of edges crossed by the ray from anywhere in the cell. */
+    static constexpr uint8_t kBoundaryCell = 2;
+    static constexpr uint8_t kBoundaryCellCrossed = 3;
+
+    /** Edge from `a` to `b`, in the vertex order the plain test visits them in. */
+    struct Edge
+    {
+        Point a;
+        Point b;
+    };
+
+    static bool containsPointInEdges(double x, double y, const Edge *edges, size_t count)
+    {
+        bool inside = false;
+        for (size_t i = 0; i < count; i++)
+        {
+            const Point &a = edges[i].a;
+            const Point &b = edges[i].b;
+            if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x)
+            {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    void buildGrid(const std::vector<Edge> &edges);
+
+    Rect _boundingBox;
+    size_t _columnCount = 0;
+    size_t _rowCount = 0;
+    double _inverseCellWidth = 0.0;
+    double _inverseCellHeight = 0.0;
+    /** Classification of the cells, row-major. Empty if the polygon is tested directly. */
+    std::vector<uint8_t> _cells;
+    /** All edges if the polygon is tested directly, otherwise the edges to test for each boundary cell, cell after cell. */
+    std::vector<Edge> _edges;
+    /** Start of the edges of each cell in `_edges`, with the end of the last cell appended. */
+    std::vector<uint32_t> _edgeOffsets;
+};
+
+} // namespace eil
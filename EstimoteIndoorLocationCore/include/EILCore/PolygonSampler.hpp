@@ -0,0 +1,77 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Geometry.hpp"
+#include "EILCore/Random.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eil {
+
+/**
+ * Draws uniformly distributed points inside a fixed polygon.
+ *
+ * The polygon is triangulated once by ear clipping. Triangles are then picked with probability proportional to their
+ * area through an alias table, and a point is drawn uniformly inside the picked triangle. Every point costs the same
+ * constant time, however concave or corridor-like the polygon is, unlike rejection sampling against the bounding box.
+ *
+ * Immutable once built; can be used from any number of threads, each with its own `Random`.
+ */
+class PolygonSampler
+{
+public:
+    /**
+     * Triangulates the polygon.
+     *
+     * @param polygon Vertices of a simple polygon, clockwise or counter clockwise.
+     */
+    explicit PolygonSampler(const std::vector<Point> &polygon);
+
+    /** Whether the polygon could be triangulated. Self-intersecting and degenerate polygons cannot. */
+    bool isValid() const { return !_triangles.empty(); }
+
+    /** Total area of the triangles, in square meters. */
+    double area() const { return _area; }
+
+    /** Number of triangles. */
+    size_t triangleCount() const { return _triangles.size(); }
+
+    /**
+     * Draws a single point.
+     *
+     * @param random Source of randomness.
+     * @return A random point inside the polygon. The origin if the sampler is not valid.
+     */
+    Point sample(Random &random) const;
+
+    /**
+     * Fills a buffer with points drawn independently.
+     *
+     * @param random Source of randomness. The points equal those of `count` consecutive calls to `sample`.
+     * @param points Buffer receiving the points. Must hold `count` elements.
+     * @param count Number of points to draw.
+     */
+    void sample(Random &random, Point *points, size_t count) const;
+
+private:
+    struct Triangle
+    {
+        Point a;
+        /** Edges from `a`, so a point is `a + s * ab + t * ac`. */
+        Point ab;
+        Point ac;
+    };
+
+    void buildAliasTable(const std::vector<double> &areas);
+
+    std::vector<Triangle> _triangles;
+    /** Probability of keeping the picked triangle rather than switching to its alias. */
+    std::vector<double> _keepProbabilities;
+    std::vector<uint32_t> _aliases;
+    double _area = 0.0;
+};
+
+} // namespace eil
@@ -0,0 +1,83 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/PositionUpdate.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace eil {
+
+/**
+ * Describes when accumulated position updates are handed over.
+ *
+ * A batch is delivered as soon as any enabled limit is reached. If all limits are disabled, every update is delivered
+ * in a batch of its own. Setting only `maximumLatency` and `maximumDistance` works like deferred location updates in
+ * Core Location: the app is woken up once per interval, or earlier once the user walked far enough.
+ */
+struct BatchingPolicy
+{
+    /** Maximum number of updates in a batch. Zero disables the limit. */
+    size_t maximumCount = 0;
+    /** Maximum time between the first update in a batch and its delivery, in seconds. Zero disables the limit. */
+    double maximumLatency = 0.0;
+    /**
+     * Distance from the first position in a batch after which it is delivered, in meters. Zero disables the limit.
+     * Measured in a straight line, so jitter of the position of a standing user does not add up to a walk.
+     */
+    double maximumDistance = 0.0;
+};
+
+/**
+ * Contiguous buffer of position updates awaiting delivery.
+ *
+ * The buffer keeps its capacity between batches, so once it has grown to the size of a batch, accumulating updates
+ * does not allocate.
+ */
+class PositionBatch
+{
+public:
+    /**
+     * Sets the limits after which the batch is due.
+     *
+     * @param policy Batching limits.
+     */
+    void setPolicy(const BatchingPolicy &policy);
+
+    /**
+     * Appends an update to the batch.
+     *
+     * @param update Position update.
+     */
+    void append(const PositionUpdate &update) { _updates.push_back(update); }
+
+    /**
+     * Checks whether the batch should be delivered.
+     *
+     * @param timestamp Current time.
+     * @return true if the batch is not empty and any of the limits was reached.
+     */
+    bool isDue(double timestamp) const;
+
+    /** Updates in the batch, oldest first. */
+    const PositionUpdate *data() const { return _updates.data(); }
+
+    /** Number of updates in the batch. */
+    size_t size() const { return _updates.size(); }
+
+    /** Whether the batch has no updates. */
+    bool empty() const { return _updates.empty(); }
+
+    /** Distance between the first and the last position in the batch, in meters. */
+    double distance() const;
+
+    /** Removes all updates, keeping the allocated capacity. */
+    void clear() { _updates.clear(); }
+
+private:
+    BatchingPolicy _policy;
+    std::vector<PositionUpdate> _updates;
+};
+
+} // namespace eil
@@ -0,0 +1,75 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/AtomicSnapshot.hpp"
+#include "EILCore/Location.hpp"
+#include "EILCore/PositionUpdate.hpp"
+#include "EILCore/SegmentIndex.hpp"
+
+namespace eil {
+
+/**
+ * Extrapolates the position of the user between position updates, e.g. to move an avatar smoothly at display rate.
+ *
+ * The engine feeds every position update of a location into its predictor; the predictor tracks a smoothed velocity
+ * and extrapolates with a constant-velocity model. Predictions are computed from a lock-free snapshot, so a render
+ * thread can query them every frame while the engine runs on another thread, without allocating and without waiting.
+ * An extrapolation that would leave the location or walk through one of its walls is not taken.
+ */
+class PositionPredictor
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param location The location positions are predicted within. Predictions never leave it or cross its walls.
+     *                 Its segment index is built here, so predictions do not have to.
+     * @param maximumHorizon Time after the last update beyond which the position is no longer extrapolated, in seconds.
+     */
+    PositionPredictor(LocationRef location, double maximumHorizon);
+
+    PositionPredictor(const PositionPredictor &) = delete;
+    PositionPredictor &operator=(const PositionPredictor &) = delete;
+
+    /**
+     * Predicts the position of the user. Lock-free and allocation free; can be called from any thread.
+     *
+     * @param timestamp Time to predict the position for, on the clock of the beacon samples.
+     * @param prediction Receives the predicted position. Its accuracy is the one of the last update.
+     * @return false if there was no position update yet; `prediction` is left untouched.
+     */
+    bool predictedPositionAt(double timestamp, PositionUpdate &prediction) const;
+
+    /**
+     * Feeds a position update. Must only be called from one thread at a time, normally by the engine.
+     *
+     * @param update The update.
+     * @param isStationary Whether inertial sensors report that the user stands still, which zeroes the velocity.
+     */
+    void addUpdate(const PositionUpdate &update, bool isStationary = false);
+
+    /** Forgets all updates. Must only be called from the thread feeding updates. */
+    void reset();
+
+    /** The location positions are predicted within. */
+    const LocationRef &location() const { return _location; }
+
+private:
+    struct State
+    {
+        bool valid = false;
+        PositionUpdate update;
+        double velocityX = 0.0;
+        double velocityY = 0.0;
+    };
+
+    LocationRef _location;
+    const SegmentIndex &_walls;
+    double _maximumHorizon;
+    // Written only by the feeding thread; `_published` is what readers see.
+    State _state;
+    AtomicSnapshot<State> _published;
+};
+
+} // namespace eil
@@ -0,0 +1,51 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Geometry.hpp"
+
+namespace eil {
+
+/**
+ * Describes the accuracy of the determined position. Counterpart of `EILPositionAccuracy`.
+ *
+ * Accuracy can be represented as a circle of given radius within which the real position is expected to be.
+ */
+enum class PositionAccuracy
+{
+    /** Accuracy is below 1m. */
+    VeryHigh = 0,
+    /** Accuracy is below 1.62m. */
+    High = 1,
+    /** Accuracy is below 2.62m. */
+    Medium = 2,
+    /** Accuracy is below 4.24m. */
+    Low = 3,
+    /** Accuracy should be thought of as comparable to location size. */
+    VeryLow = 4,
+    /** Accuracy of determined position is unknown. */
+    Unknown = 5,
+};
+
+/**
+ * Maps radius of the expected position error onto accuracy level.
+ *
+ * @param radius Radius within which the real position is expected to be, in meters.
+ * @return Accuracy level.
+ */
+PositionAccuracy accuracyForRadius(double radius);
+
+/** A single position update. Counterpart of the arguments of `indoorLocationManager:didUpdatePosition:withAccuracy:inLocation:`. */
+struct PositionUpdate
+{
+    /** The position inside the location. */
+    OrientedPoint position;
+    /** The accuracy of the determined position. */
+    PositionAccuracy accuracy = PositionAccuracy::Unknown;
+    /** Radius within which the real position is expected to be, in meters. */
+    double accuracyRadius = 0.0;
+    /** Time the position was determined for, on the clock of the beacon samples. */
+    double timestamp = 0.0;
+};
+
+} // namespace eil
@@ -0,0 +1,355 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/AlgorithmParameters.hpp"
+#include "EILCore/BeaconFilterBank.hpp"
+#include "EILCore/BeaconSample.hpp"
+#include "EILCore/DispatchQueue.hpp"
+#include "EILCore/FloorDetector.hpp"
+#include "EILCore/GeofenceMonitor.hpp"
+#include "EILCore/InertialFusion.hpp"
+#include "EILCore/Location.hpp"
+#include "EILCore/ParticleFilter.hpp"
+#include "EILCore/PositionBatch.hpp"
+#include "EILCore/PositionPredictor.hpp"
+#include "EILCore/PositioningMetrics.hpp"
+#include "EILCore/PositioningSnapshot.hpp"
+#include "EILCore/PositionUpdate.hpp"
+#include "EILCore/ScanTrace.hpp"
+#include "EILCore/SensorSample.hpp"
+#include "EILCore/SignalMap.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eil {
+
+/**
+ * Headless positioning engine. It is the platform-neutral core behind `EILIndoorLocationManager`.
+ *
+ * The engine accepts timestamped beacon samples and emits position updates every `AlgorithmParameters::updateInterval`
+ * seconds for each location position updates were started for. All locations share a single stream of beacon samples
+ * and a single set of per-beacon signal statistics, so adjacent locations sharing beacons are positioned at once and
+ * a location started later does not warm up from scratch. A location is warmed up once the signal of any of its beacons
+ * has been observed for `AlgorithmParameters::warmUpDuration` seconds.
+ *
+ * Time is driven exclusively by the timestamps of the samples and by `advanceTo`, so the engine runs equally well
+ * on live scans and recorded ones.
+ *
+ * Not thread-safe; all calls have to be serialized by the owner. Handlers are invoked synchronously from within
+ * `processSample` or `advanceTo`, unless a delegate queue is set.
+ */
+class PositioningEngine
+{
+public:
+    /** Block invoked with every position update, together with the location for which the position was updated. */
+    typedef std::function<void(const PositionUpdate &update, const Location &location)> PositionHandler;
+
+    /**
+     * Block invoked with a batch of position updates for a single location.
+     *
+     * @param updates Contiguous buffer of updates, oldest first. Valid only for the duration of the call.
+     * @param count Number of updates in the buffer.
+     * @param location The location for which the positions were updated.
+     */
+    typedef std::function<void(const PositionUpdate *updates, size_t count, const Location &location)> BatchHandler;
+
+    /**
+     * Designated initializer. Position updates are not delivered until `startPositionUpdates` is called.
+     *
+     * @param parameters Parameters of the positioning algorithm.
+     */
+    explicit PositioningEngine(const AlgorithmParameters &parameters = AlgorithmParameters());
+
+    /**
+     * Returns an engine delivering position updates for a single location.
+     *
+     * @param location The location for which position updates are delivered.
+     * @param parameters Parameters of the positioning algorithm.
+     */
+    explicit PositioningEngine(LocationRef location, const AlgorithmParameters &parameters = AlgorithmParameters());
+
+    /**
+     * Sets the block invoked with every position update.
+     *
+     * @param handler The block. Can be empty.
+     */
+    void setPositionHandler(PositionHandler handler);
+
+    /**
+     * Sets the block invoked with batches of position updates.
+     *
+     * Updates are accumulated per location and handed over once a limit of the policy is reached. Limits are checked
+     * on every update interval, so latency limits shorter than `AlgorithmParameters::updateInterval` act like no limit.
+     * The batch handler works independently of the position handler; set only the batch handler to avoid per-update calls.
+     * Deferred state changes of the geofence monitor are handed over right before every batch.
+     *
+     * @param handler The block. Can be empty, which discards pending batches.
+     * @param policy Limits after which a batch is handed over.
+     */
+    void setBatchHandler(BatchHandler handler, const BatchingPolicy &policy);
+
+    /** Hands over pending batches of all locations right away, regardless of the batching policy. */
+    void flushBatches();
+
+    /**
+     * Sets the queue on which handlers are invoked.
+     *
+     * By default handlers are invoked synchronously, on the thread feeding the engine. With a queue set, the engine only
+     * schedules the handlers and carries on, so heavy work in them no longer delays the filter. Handlers then run
+     * concurrently with the engine and must not call into it directly.
+     *
+     * @param queue A serial queue or `nullptr` to invoke handlers synchronously.
+     */
+    void setDelegateQueue(std::shared_ptr<DispatchQueue> queue) { _delegateQueue = std::move(queue); }
+
+    /** The queue on which handlers are invoked, `nullptr` if they are invoked synchronously. */
+    const std::shared_ptr<DispatchQueue> &delegateQueue() const { return _delegateQueue; }
+
+    /**
+     * Enables latency metrics. Every position update is timed from the newest beacon sample it takes into account,
+     * through the filter step, to the invocation of the position handler, including time spent on the delegate queue.
+     *
+     * @param metrics Metrics to record into, can be shared by several engines. `nullptr` disables metrics, which is the default.
+     */
+    void setMetrics(std::shared_ptr<PositioningMetrics> metrics) { _metrics = std::move(metrics); }
+
+    /** Metrics updates are recorded into, `nullptr` if metrics are disabled. */
+    const std::shared_ptr<PositioningMetrics> &metrics() const { return _metrics; }
+
+    /**
+     * Sets the cache of precomputed signal maps. Locations started from now on, and those already started, evaluate
+     * the signal model through their map, which is computed and stored on the first start and memory-mapped afterwards.
+     *
+     * @param cache The cache or `nullptr` to evaluate the signal model directly.
+     */
+    void setSignalMapCache(std::shared_ptr<SignalMapCache> cache);
+
+    /**
+     * Starts the delivery of position updates for the specified location, in addition to the locations already started.
+     *
+     * Starting position updates for a location already started does nothing.
+     *
+     * @param location The location.
+     */
+    void startPositionUpdates(LocationRef location);
+
+    /**
+     * Stops the delivery of position updates for the specified location. A pending batch of the location is handed over first.
+     *
+     * @param location The location. It need not be the exact same object that was started, but its identifier should be the same.
+     */
+    void stopPositionUpdates(const Location &location);
+
+    /** Stops the delivery of position updates for all locations. */
+    void stopPositionUpdates();
+
+    /** Locations for which position updates are delivered, in the order they were started. */
+    std::vector<LocationRef> locations() const;
+
+    /**
+     * Feeds a beacon sample into the engine. Samples are expected in non-decreasing timestamp order.
+     *
+     * Samples of beacons which do not belong to any of the locations are ignored.
+     *
+     * @param sample Received beacon sample.
+     */
+    void processSample(const BeaconSample &sample);
+
+    /**
+     * Feeds a sensor sample into the engine.
+     *
+     * The sample is recorded if recording is enabled, and handed over to the inertial fusion if one is set. In that case
+     * the thread calling this method is the producer of all sensor streams of the fusion; for the lowest latency,
+     * push samples to the fusion directly from the sensor callbacks instead.
+     *
+     * @param sample Sensor sample.
+     */
+    void processSensorSample(const SensorSample &sample);
+
+    /**
+     * Enables the inertial positioning mode. At every update the engine reads the motion of the user published by the
+     * fusion, without locking, and lets it drive the motion model: particles stay put while the user stands and spread
+     * with the measured walking pace otherwise. Motion older than `AlgorithmParameters::beaconTimeout` is ignored.
+     *
+     * @param fusion The fusion, fed with sensor samples from any threads. `nullptr` for the standard positioning mode.
+     */
+    void setInertialFusion(std::shared_ptr<InertialFusion> fusion) { _inertialFusion = std::move(fusion); }
+
+    /** The inertial fusion in use, `nullptr` in the standard positioning mode. */
+    const std::shared_ptr<InertialFusion> &inertialFusion() const { return _inertialFusion; }
+
+    /**
+     * Sets the geofence monitor fed with every beacon sample and every `advanceTo`, including samples of beacons
+     * which do not belong to any location position updates are started for. State changes the monitor defers are
+     * handed over with the next batch, on the delegate queue if one is set, right before the batch handler. Set the
+     * queue on the monitor too, see `GeofenceMonitor::setDelegateQueue`, for changes it delivers on its own.
+     *
+     * @param monitor The monitor or `nullptr` to stop feeding it.
+     */
+    void setGeofenceMonitor(std::shared_ptr<GeofenceMonitor> monitor) { _geofenceMonitor = std::move(monitor); }
+
+    /** The geofence monitor fed with beacon samples, `nullptr` if none. */
+    const std::shared_ptr<GeofenceMonitor> &geofenceMonitor() const { return _geofenceMonitor; }
+
+    /**
+     * Positions the user in a multi-storey building. Starts position updates for every floor of the detector's
+     * building. Filters of all floors keep running on the shared beacon statistics, but position updates and batches
+     * are delivered for the floor the detector considers current only. On a floor change the pending batch of the
+     * previous floor is handed over and the new floor continues from its already converged estimate. `lastUpdate` and
+     * the predictor of a floor only reflect updates delivered while it was current.
+     *
+     * @param detector The floor detector or `nullptr` to deliver updates of all started locations again. Floors stay
+     *                 started either way.
+     */
+    void setFloorDetector(std::shared_ptr<FloorDetector> detector);
+
+    /** The floor detector in use, `nullptr` if none. */
+    const std::shared_ptr<FloorDetector> &floorDetector() const { return _floorDetector; }
+
+    /**
+     * Enables recording of every raw beacon and sensor sample passed to the engine, including samples of beacons
+     * which do not belong to any location. Locations are recorded right away and whenever position updates are started
+     * or stopped for them.
+     *
+     * @param writer An open trace writer or `nullptr` to stop recording.
+     */
+    void setTraceWriter(std::shared_ptr<TraceWriter> writer);
+
+    /**
+     * Advances the clock of the engine without a new sample, running every update that became due.
+     *
+     * @param timestamp Current time.
+     */
+    void advanceTo(double timestamp);
+
+    /** Discards all beacon statistics and position estimates, including the warm-up progress. Locations stay started. */
+    void reset();
+
+    /**
+     * Saves the positioning state to a file: signal statistics of the beacons, and the estimate and the last position
+     * of every started location with an identifier. Call it when position updates are stopped or the app moves to the background.
+     *
+     * @param path Path of the file. An existing snapshot is replaced.
+     * @return true on success.
+     */
+    bool saveSnapshot(const std::string &path) const;
+
+    /**
+     * Resumes from state saved with `saveSnapshot`, so positions are delivered as soon as beacons heard before saving
+     * are heard again, instead of after the warm-up.
+     *
+     * Beacon statistics are applied with the first sample. Location state is matched by identifier and applied with the
+     * first sample or when the location is started, whichever comes later; state of a location whose content changed
+     * since saving is ignored. The time between saving and resuming is taken from the wall clock, and the restored
+     * estimate widens by the distance the user could have walked meanwhile.
+     *
+     * @param path Path of the file.
+     * @param maximumAge Age in seconds after which a snapshot is rejected; the user may have walked anywhere by then.
+     * @return false if the snapshot cannot be read or is too old.
+     */
+    bool restoreSnapshot(const std::string &path, double maximumAge = 300.0);
+
+    /** Parameters of the positioning algorithm. */
+    const AlgorithmParameters &parameters() const { return _parameters; }
+
+    /** Smoothed beacon statistics shared by all locations. */
+    const BeaconFilterBank &beaconFilterBank() const { return _beacons; }
+
+    /**
+     * Returns the most recent position update delivered for the location.
+     *
+     * @param location The location.
+     * @return The update or `nullptr` if no update was delivered since the start or the last reset.
+     */
+    const PositionUpdate *lastUpdate(const Location &location) const;
+
+    /**
+     * Predicts the position of the user between updates with a constant-velocity model. Cheap enough for every frame.
+     *
+     * @param location The location.
+     * @param timestamp Time to predict the position for, on the clock of the beacon samples.
+     * @param prediction Receives the predicted position.
+     * @return false if position updates are not started for the location or no update was delivered yet.
+     */
+    bool predictedPositionAt(const Location &location, double timestamp, PositionUpdate &prediction) const;
+
+    /**
+     * Returns the predictor fed with the updates of the location. Unlike the engine, the predictor can be queried from
+     * any thread, e.g. by a renderer running at display rate while the engine runs on its own queue.
+     *
+     * @param location The location.
+     * @return The predictor or `nullptr` if position updates are not started for the location. It stays valid, but
+     *         is no longer fed, once position updates for the location are stopped.
+     */
+    std::shared_ptr<const PositionPredictor> positionPredictor(const Location &location) const;
+
+private:
+    struct LocationSession
+    {
+        LocationSession(LocationRef location, const AlgorithmParameters &parameters)
+            : filter(location, parameters),
+              predictor(std::make_shared<PositionPredictor>(location, 2.0 * parameters.updateInterval)) {}
+
+        ParticleFilter filter;
+        bool stopped = false;
+        /** Last update delivered to the handlers, which the predictor is fed with. */
+        bool hasPosition = false;
+        PositionUpdate lastUpdate;
+        std::shared_ptr<PositionPredictor> predictor;
+        /** Last estimate of the filter, also kept on inactive floors so orientation carries over a floor change. */
+        bool hasEstimate = false;
+        PositionUpdate lastEstimate;
+        PositionBatch batch;
+        bool deliveringBatch = false;
+    };
+
+    LocationSession *sessionForLocation(const Location &location);
+    const LocationSession *sessionForLocation(const Location &location) const;
+    void removeStoppedSessions();
+    void deliverBatch(LocationSession &session);
+    void endDispatch();
+    void dispatchPositionUpdate(const PositionUpdate &update, const LocationRef &location, PositionUpdateTiming timing);
+    bool isWarmedUp(const Location &location, double timestamp) const;
+    bool isInactiveFloor(const Location &location) const;
+    void runDueSteps(double timestamp);
+    void runStep(double timestamp);
+    double restoredTimeOffset() const;
+    void applyRestoredBeacons();
+    void applyRestoredLocation(LocationSession &session);
+
+    AlgorithmParameters _parameters;
+    BeaconFilterBank _beacons;
+    std::vector<std::unique_ptr<LocationSession>> _sessions;
+    // Number of started locations each beacon belongs to.
+    std::unordered_map<BeaconId, int> _beaconReferences;
+    // Handlers are kept behind shared pointers, so blocks scheduled on the delegate queue can cheaply keep them alive.
+    std::shared_ptr<const PositionHandler> _positionHandler;
+    std::shared_ptr<const BatchHandler> _batchHandler;
+    std::shared_ptr<DispatchQueue> _delegateQueue;
+    BatchingPolicy _batchingPolicy;
+    std::shared_ptr<TraceWriter> _traceWriter;
+    std::shared_ptr<SignalMapCache> _signalMapCache;
+    std::shared_ptr<PositioningMetrics> _metrics;
+    std::shared_ptr<InertialFusion> _inertialFusion;
+    std::shared_ptr<GeofenceMonitor> _geofenceMonitor;
+    std::shared_ptr<FloorDetector> _floorDetector;
+    // Monotonic time the newest beacon sample was added to the beacon statistics, tracked only with metrics enabled.
+    double _sampleReceivedAt = 0.0;
+
+    // Snapshot passed to `restoreSnapshot`, drained as its state is applied.
+    std::unique_ptr<PositioningSnapshot> _restoredSnapshot;
+
+    bool _started = false;
+    // Timestamp of the most recent sample or `advanceTo` call.
+    double _clock = 0.0;
+    // Depth of handler invocations in progress; sessions are removed only outside of them.
+    int _dispatchDepth = 0;
+    double _nextStepTimestamp = 0.0;
+};
+
+} // namespace eil
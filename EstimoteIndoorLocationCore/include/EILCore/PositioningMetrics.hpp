@@ -0,0 +1,182 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eil {
+
+/**
+ * Times at which a single position update passed the stages of the engine.
+ *
+ * All times are in seconds on the monotonic clock of `PositioningMetrics::now`, not on the clock of the beacon samples.
+ */
+struct PositionUpdateTiming
+{
+    /** The newest beacon sample taken into account by the update was passed to the engine. */
+    double sampleReceived = 0.0;
+    /** The filter step started. */
+    double stepStarted = 0.0;
+    /** The filter step finished. */
+    double stepFinished = 0.0;
+    /** The position handler was invoked. Equals `stepFinished` if there is no position handler. */
+    double dispatched = 0.0;
+    /** The position handler returned. Equals `dispatched` if there is no position handler. */
+    double handlerFinished = 0.0;
+};
+
+/**
+ * Histogram of latencies with logarithmic buckets, four per octave from 1 µs up to about two minutes.
+ *
+ * Percentiles are accurate to within 10% of the value, independently of its magnitude. Not thread-safe.
+ */
+class LatencyHistogram
+{
+public:
+    /** Number of buckets per doubling of the latency. */
+    static constexpr int kBucketsPerOctave = 4;
+    /** Total number of buckets. Latencies beyond the last bucket are counted in it. */
+    static constexpr int kBucketCount = 27 * kBucketsPerOctave;
+
+    /**
+     * Adds a latency to the histogram.
+     *
+     * @param seconds The latency, in seconds. Negative values are counted as zero.
+     */
+    void record(double seconds);
+
+    /**
+     * Adds all latencies of another histogram.
+     *
+     * @param other The histogram.
+     */
+    void merge(const LatencyHistogram &other);
+
+    /** Removes all latencies. */
+    void reset();
+
+    /** Number of latencies recorded. */
+    uint64_t count() const { return _count; }
+
+    /** Mean latency, in seconds. Zero if no latency was recorded. */
+    double mean() const { return _count > 0 ? _sum / _count : 0.0; }
+
+    /** Maximum latency, in seconds. */
+    double max() const { return _max; }
+
+    /**
+     * Estimates a percentile of the latencies.
+     *
+     * @param fraction The percentile as a fraction, e.g. 0.99.
+     * @return The latency, in seconds. Zero if no latency was recorded.
+     */
+    double percentile(double fraction) const;
+
+private:
+    std::array<uint32_t, kBucketCount> _buckets{};
+    uint64_t _count = 0;
+    double _sum = 0.0;
+    double _max = 0.0;
+};
+
+/** Summary of a latency histogram. All values are in seconds. */
+struct LatencySummary
+{
+    uint64_t count = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * Opt-in latency metrics of a positioning engine.
+ *
+ * Keeps rolling histograms of the last `window` seconds for each stage of the pipeline:
+ * - end to end: from the newest beacon sample to the invocation of the position handler,
+ * - step: duration of the filter step,
+ * - dispatch: from the end of the step to the invocation of the position handler, e.g. waiting on the delegate queue,
+ * - handler: duration of the position handler.
+ *
+ * Thread-safe; updates are recorded from the engine or from the delegate queue while the owner reads them.
+ */
+class PositioningMetrics
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param window Length of the rolling window, in seconds.
+     * @param slices Number of slices the window is made of. The window moves in steps of `window / slices`.
+     */
+    explicit PositioningMetrics(double window = 60.0, int slices = 6);
+
+    /** Current time on the monotonic clock used for timings, in seconds. */
+    static double now();
+
+    /**
+     * Records the timing of a single position update.
+     *
+     * @param timing Timing of the update.
+     */
+    void recordUpdate(const PositionUpdateTiming &timing);
+
+    /** Timing of the most recent position update. */
+    PositionUpdateTiming lastTiming() const;
+
+    /** Number of updates recorded since creation or the last reset, including those outside of the window. */
+    uint64_t totalUpdateCount() const;
+
+    /** Latency from the newest beacon sample to the invocation of the position handler. */
+    LatencySummary endToEnd() const;
+    /** Duration of the filter steps. */
+    LatencySummary step() const;
+    /** Latency from the end of the filter step to the invocation of the position handler. */
+    LatencySummary dispatch() const;
+    /** Duration of the position handler. */
+    LatencySummary handler() const;
+
+    /**
+     * Exports the summaries of all stages as a single-line JSON object, suitable for shipping to a monitoring backend.
+     * Latencies are in milliseconds.
+     *
+     * @return The JSON object.
+     */
+    std::string exportJSON() const;
+
+    /** Discards all recorded timings. */
+    void reset();
+
+private:
+    enum Stage
+    {
+        StageEndToEnd,
+        StageStep,
+        StageDispatch,
+        StageHandler,
+        StageCount,
+    };
+
+    struct Slice
+    {
+        double start = 0.0;
+        std::array<LatencyHistogram, StageCount> stages;
+    };
+
+    void rotate(double timestamp) const;
+    LatencySummary summary(Stage stage) const;
+
+    double _sliceDuration;
+    mutable std::mutex _mutex;
+    mutable std::vector<Slice> _slices;
+    mutable size_t _currentSlice = 0;
+    PositionUpdateTiming _lastTiming;
+    uint64_t _totalUpdateCount = 0;
+};
+
+} // namespace eil
@@ -0,0 +1,78 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/BeaconFilterBank.hpp"
+#include "EILCore/BeaconSample.hpp"
+#include "EILCore/ParticleFilter.hpp"
+#include "EILCore/PositionUpdate.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace eil {
+
+/** Saved signal statistics of a single beacon. */
+struct BeaconSnapshot
+{
+    /** Compact beacon identifier. */
+    BeaconId beacon = 0;
+    /** Statistics of the beacon. Times are on the clock of the engine that saved them. */
+    BeaconState state;
+};
+
+/** Saved positioning state of a single location. */
+struct LocationSnapshot
+{
+    /** Identifier of the location. */
+    std::string identifier;
+    /** Fingerprint of the location content, see `locationFingerprint`. */
+    uint64_t fingerprint = 0;
+    /** Whether `lastUpdate` holds a delivered position. */
+    bool hasPosition = false;
+    /** The most recent position update delivered for the location. */
+    PositionUpdate lastUpdate;
+    /** Time of the last filter step. */
+    double filterTimestamp = 0.0;
+    /** Particles of the filter, empty if the filter was not initialized. */
+    std::vector<Particle> particles;
+};
+
+/**
+ * Positioning state of an engine, saved so that positioning can resume without warming up again.
+ *
+ * Times inside the snapshot are on the clock of the engine that saved it, which need not survive a restart of the app.
+ * `savedAt` ties that clock to the wall clock, so the state can be moved onto the clock of another engine.
+ */
+struct PositioningSnapshot
+{
+    /** Wall-clock time of saving, in seconds since 1970. */
+    double savedAt = 0.0;
+    /** Engine time of saving. */
+    double timestamp = 0.0;
+    /** Statistics of beacons heard before saving. */
+    std::vector<BeaconSnapshot> beacons;
+    /** State of locations with an identifier. */
+    std::vector<LocationSnapshot> locations;
+};
+
+/**
+ * Writes the snapshot to a file. The file is replaced atomically, so a crash while saving leaves the previous snapshot intact.
+ *
+ * @param snapshot The snapshot.
+ * @param path Path of the file.
+ * @return true on success.
+ */
+bool writePositioningSnapshot(const PositioningSnapshot &snapshot, const std::string &path);
+
+/**
+ * Reads a snapshot written by `writePositioningSnapshot`.
+ *
+ * @param path Path of the file.
+ * @param snapshot Receives the snapshot. Left untouched on failure.
+ * @return false if the file cannot be read, is malformed or was written by an incompatible version.
+ */
+bool readPositioningSnapshot(const std::string &path, PositioningSnapshot &snapshot);
+
+} // namespace eil
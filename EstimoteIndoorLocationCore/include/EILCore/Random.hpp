@@ -0,0 +1,101 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace eil {
+
+/**
+ * Source of randomness of the positioning core.
+ *
+ * The generator is the standard `std::mt19937_64`, whose sequence is fully specified, but the distributions are
+ * implemented here: the ones of the standard library differ between implementations, so the same seed would give
+ * different particles with libc++ and libstdc++. With equal seeds, all sampling in the core is bit-identical on a given
+ * platform; across platforms only the rounding of `log`, `sin` and `cos` in the math library can make a difference.
+ *
+ * Not thread-safe.
+ */
+class Random
+{
+public:
+    /** Seeds the generator from `std::random_device`, so every instance produces a different sequence. */
+    Random() : _generator(std::random_device()()) {}
+
+    /**
+     * Seeds the generator explicitly, so the sequence is reproducible.
+     *
+     * @param seed The seed.
+     */
+    explicit Random(uint64_t seed) : _generator(seed) {}
+
+    /**
+     * Restarts the sequence from a seed.
+     *
+     * @param seed The seed.
+     */
+    void seed(uint64_t seed)
+    {
+        _generator.seed(seed);
+        _hasSpareNormal = false;
+    }
+
+    /** Returns the next raw 64-bit value. */
+    uint64_t next() { return _generator(); }
+
+    /** Returns a uniformly distributed value in [0, 1). */
+    double uniform() { return static_cast<double>(_generator() >> 11) * (1.0 / 9007199254740992.0); }
+
+    /**
+     * Returns a uniformly distributed value in [minimum, maximum).
+     *
+     * @param minimum Lower bound.
+     * @param maximum Upper bound.
+     */
+    double uniform(double minimum, double maximum) { return minimum + (maximum - minimum) * uniform(); }
+
+    /**
+     * Returns a normally distributed value. Uses the Box-Muller transform; every other call is served from the spare value.
+     *
+     * @param mean Mean of the distribution.
+     * @param standardDeviation Standard deviation of the distribution.
+     */
+    double normal(double mean, double standardDeviation)
+    {
+        if (_hasSpareNormal)
+        {
+            _hasSpareNormal = false;
+            return mean + standardDeviation * _spareNormal;
+        }
+        // 1 - uniform() lies in (0, 1], so the logarithm stays finite.
+        double radius = std::sqrt(-2.0 * std::log(1.0 - uniform()));
+        double angle = 6.283185307179586 * uniform();
+        _spareNormal = radius * std::sin(angle);
+        _hasSpareNormal = true;
+        return mean + standardDeviation * radius * std::cos(angle);
+    }
+
+    /**
+     * Derives a seed for an independent stream, e.g. one per location, from a base seed. Uses the SplitMix64 finalizer.
+     *
+     * @param seed Base seed.
+     * @param stream Identifier of the stream.
+     * @return Seed of the stream.
+     */
+    static uint64_t mixSeed(uint64_t seed, uint64_t stream)
+    {
+        uint64_t value = seed + 0x9e3779b97f4a7c15ULL * (stream + 1);
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+private:
+    std::mt19937_64 _generator;
+    double _spareNormal = 0.0;
+    bool _hasSpareNormal = false;
+};
+
+} // namespace eil
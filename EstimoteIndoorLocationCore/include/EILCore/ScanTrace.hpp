@@ -0,0 +1,168 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/BeaconSample.hpp"
+#include "EILCore/Location.hpp"
+#include "EILCore/SensorSample.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eil {
+
+/** Kind of a record stored in a scan trace. */
+enum class TraceRecordType
+{
+    /** The location for which positioning was started. */
+    Location,
+    /** Positioning was stopped for a location recorded earlier. */
+    LocationStop,
+    /** A raw beacon advertisement. */
+    BeaconSample,
+    /** A raw sensor sample. */
+    SensorSample,
+};
+
+/** A single record read from a scan trace. Only the member matching `type` is valid. */
+struct TraceRecord
+{
+    TraceRecordType type = TraceRecordType::BeaconSample;
+    /** The location started or stopped; a stop refers to the very object its start record was read into. */
+    LocationRef location;
+    BeaconSample beaconSample;
+    SensorSample sensorSample;
+};
+
+/**
+ * Records raw beacon advertisements and sensor samples into a compact, append-only binary scan trace.
+ *
+ * Timestamps are stored as microsecond deltas and beacons are interned on first use, with their compact identifier and,
+ * if a recorded location or `setBeaconIdentifier` tells it, their identifier string, so a typical advertisement takes
+ * 4-5 bytes and a trace can still be mapped back to physical beacons. Records are only ever appended; a trace cut short by a crash stays readable up
+ * to the last complete record. Not thread-safe.
+ */
+class TraceWriter
+{
+public:
+    TraceWriter() = default;
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter &) = delete;
+    TraceWriter &operator=(const TraceWriter &) = delete;
+
+    /**
+     * Creates a new trace file, replacing an existing one.
+     *
+     * @param path Path of the trace file.
+     * @return true if the file was created.
+     */
+    bool open(const std::string &path);
+
+    /** Whether the trace file is open. */
+    bool isOpen() const { return _file != nullptr; }
+
+    /**
+     * Records a location for which positioning is started. Identifiers of its beacons are stored with their first
+     * advertisement.
+     *
+     * @param location The location.
+     */
+    void writeLocation(const Location &location);
+
+    /**
+     * Records that positioning is stopped for a location. Ignored for locations not recorded by `writeLocation`.
+     *
+     * @param location The location, the same object that was passed to `writeLocation`.
+     */
+    void writeLocationStop(const Location &location);
+
+    /**
+     * Sets the identifier stored for a beacon no recorded location knows. Only affects beacons not advertised yet.
+     *
+     * @param beacon Compact identifier of the beacon.
+     * @param identifier Identifier of the beacon (MAC address or identifier).
+     */
+    void setBeaconIdentifier(BeaconId beacon, const std::string &identifier) { _beaconIdentifiers[beacon] = identifier; }
+
+    /**
+     * Records a raw beacon advertisement.
+     *
+     * @param sample Received beacon sample.
+     */
+    void writeBeaconSample(const BeaconSample &sample);
+
+    /**
+     * Records a raw sensor sample.
+     *
+     * @param sample Sensor sample.
+     */
+    void writeSensorSample(const SensorSample &sample);
+
+    /** Writes buffered records to the file. */
+    void flush();
+
+    /** Flushes buffered records and closes the file. */
+    void close();
+
+private:
+    void putTimestamp(double timestamp);
+    void flushIfNeeded();
+
+    FILE *_file = nullptr;
+    std::string _buffer;
+    int64_t _lastMicroseconds = 0;
+    std::unordered_map<BeaconId, uint32_t> _beaconIndices;
+    std::unordered_map<BeaconId, std::string> _beaconIdentifiers;
+    /** Locations in the order they were recorded; stop records refer to them by index. */
+    std::vector<const Location *> _locations;
+};
+
+/**
+ * Reads records of a scan trace written by `TraceWriter`.
+ */
+class TraceReader
+{
+public:
+    /**
+     * Loads the trace file.
+     *
+     * @param path Path of the trace file.
+     * @return true if the file exists and has a valid header.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * Reads the next record.
+     *
+     * @param record Record to fill.
+     * @return false at the end of the trace or at the first incomplete or malformed record.
+     */
+    bool next(TraceRecord &record);
+
+    /** Whether reading stopped because of a truncated or malformed record rather than at the clean end of the trace. */
+    bool isTruncated() const { return _truncated; }
+
+    /**
+     * Returns the identifier recorded for a beacon whose advertisements were read so far.
+     *
+     * @param beacon Compact identifier of the beacon.
+     * @return The identifier, empty if the trace does not know it.
+     */
+    const std::string &beaconIdentifier(BeaconId beacon) const;
+
+private:
+    std::vector<uint8_t> _data;
+    size_t _offset = 0;
+    uint16_t _version = 0;
+    int64_t _lastMicroseconds = 0;
+    std::vector<BeaconId> _beacons;
+    std::unordered_map<BeaconId, std::string> _beaconIdentifiers;
+    std::vector<LocationRef> _locations;
+    bool _truncated = false;
+};
+
+} // namespace eil
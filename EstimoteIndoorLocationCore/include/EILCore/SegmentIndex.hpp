@@ -0,0 +1,163 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Geometry.hpp"
+#include "EILCore/Location.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace eil {
+
+/** Kinds of segments in a `SegmentIndex`, as bits to combine into a filter. */
+enum SegmentKinds : unsigned
+{
+    /** Boundary segments of the location. */
+    kWallSegments = 1u << 0,
+    /** Linear objects of type `LinearObjectType::Door`. */
+    kDoorSegments = 1u << 1,
+    /** Linear objects of type `LinearObjectType::Window`. */
+    kWindowSegments = 1u << 2,
+    kAllSegments = kWallSegments | kDoorSegments | kWindowSegments,
+};
+
+/** Result of a nearest segment query. */
+struct SegmentHit
+{
+    /** Kind of the segment, one of the bits of `SegmentKinds`. Zero if nothing was found. */
+    unsigned kind = 0;
+    /** Index of the segment in `Location::boundarySegments` for walls, otherwise in `Location::linearObjects`. */
+    size_t index = 0;
+    /** Point of the segment closest to the queried point. */
+    Point closestPoint;
+    /** Distance between the queried point and `closestPoint`. Infinite if nothing was found. */
+    double distance = std::numeric_limits<double>::infinity();
+
+    /** @return true if a segment was found. */
+    bool found() const { return kind != 0; }
+};
+
+/**
+ * Bounding volume hierarchy over the walls, doors and windows of a location, for nearest segment queries.
+ *
+ * Segments are split recursively along the longer axis of their centers into a flat binary tree of boxes. A query
+ * visits the nearer child first and skips boxes farther than the best segment found so far, so it touches a few dozen
+ * segments even in venues with thousands of them. Batched queries seed the search with the segment found for the
+ * previous point, which prunes most of the tree for points close to each other, like particles or a walked path.
+ *
+ * Ties between equally distant segments are broken by their order in the tree, so single and batched queries always
+ * return the same segment. Immutable once built; can be used from any number of threads.
+ */
+class SegmentIndex
+{
+public:
+    /**
+     * Builds the index.
+     *
+     * @param location Location whose boundary segments and linear objects are indexed.
+     */
+    explicit SegmentIndex(const Location &location);
+
+    /** Number of indexed segments. */
+    size_t segmentCount() const { return _segments.size(); }
+
+    /**
+     * Finds the segment closest to a point.
+     *
+     * @param point The point.
+     * @param kinds Bits of `SegmentKinds` to consider.
+     * @return The closest segment, or a hit that was not found if there are no segments of the given kinds.
+     */
+    SegmentHit nearestSegment(const Point &point, unsigned kinds = kAllSegments) const;
+
+    /**
+     * Computes the distance from a point to the closest segment.
+     *
+     * @param point The point.
+     * @param kinds Bits of `SegmentKinds` to consider.
+     * @return Distance in meters, infinite if there are no segments of the given kinds.
+     */
+    double distanceToNearest(const Point &point, unsigned kinds = kAllSegments) const
+    {
+        return nearestSegment(point, kinds).distance;
+    }
+
+    /**
+     * Finds the closest segment for each point of a batch.
+     *
+     * @param points Points to query.
+     * @param count Number of points.
+     * @param hits Receives the closest segment of each point. Must hold `count` elements.
+     * @param kinds Bits of `SegmentKinds` to consider.
+     */
+    void nearestSegments(const Point *points, size_t count, SegmentHit *hits, unsigned kinds = kAllSegments) const;
+
+    /**
+     * Computes the distance to the closest segment for each point of a batch.
+     *
+     * @param points Points to query.
+     * @param count Number of points.
+     * @param distances Receives the distance of each point. Must hold `count` elements.
+     * @param kinds Bits of `SegmentKinds` to consider.
+     */
+    void distancesToNearest(const Point *points, size_t count, double *distances, unsigned kinds = kAllSegments) const;
+
+    /**
+     * Checks if a line segment touches any indexed segment, e.g. whether a straight walk crosses a wall.
+     *
+     * @param a First end point of the line segment.
+     * @param b Second end point of the line segment.
+     * @param kinds Bits of `SegmentKinds` to consider.
+     * @return true if the line segment has at least one common point with a segment of the given kinds.
+     */
+    bool intersects(const Point &a, const Point &b, unsigned kinds = kAllSegments) const;
+
+private:
+    /** Segment prepared for distance computations. */
+    struct Segment
+    {
+        Point origin;
+        Point direction;
+        /** Reciprocal of the squared length, zero for degenerate segments. */
+        double inverseLengthSquared;
+        unsigned kind;
+        uint32_t index;
+    };
+
+    /** Node of the tree. Leaves hold a range of `_segments`, inner nodes their two children. */
+    struct Node
+    {
+        Rect box;
+        /** Union of the kinds of all segments below the node. */
+        unsigned kinds;
+        /** First segment of a leaf, or the first child of an inner node. The second child follows it. */
+        uint32_t first;
+        /** Number of segments of a leaf, zero for inner nodes. */
+        uint32_t count;
+    };
+
+    /** Turns the segments at positions [begin, end) of `order` into the subtree of the given node. */
+    void build(const std::vector<Segment> &segments, const std::vector<Point> &centers, std::vector<uint32_t> &order,
+               uint32_t node, uint32_t begin, uint32_t end);
+
+    /**
+     * Searches the tree for the closest segment.
+     *
+     * @param best Position in `_segments` of a segment of the given kinds to start from, which bounds the search, or
+     *             `UINT32_MAX`. Receives the position of the closest segment.
+     * @return Squared distance to the closest segment.
+     */
+    double search(const Point &point, unsigned kinds, uint32_t &best) const;
+
+    SegmentHit makeHit(const Point &point, uint32_t best) const;
+
+    static double distanceSquared(const Segment &segment, const Point &point, Point &closest);
+
+    std::vector<Segment> _segments;
+    std::vector<Node> _nodes;
+};
+
+} // namespace eil
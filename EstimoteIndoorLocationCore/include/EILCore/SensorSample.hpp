@@ -0,0 +1,37 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+
+namespace eil {
+
+/** Kind of the inertial or environmental sensor that produced a sample. */
+enum class SensorType : uint8_t
+{
+    /** User acceleration in g, as reported by CoreMotion. */
+    Accelerometer = 1,
+    /** Rotation rate in radians per second. */
+    Gyroscope = 2,
+    /** Magnetic field in microteslas. */
+    Magnetometer = 3,
+    /** Atmospheric pressure in kilopascals, stored in `x`. */
+    Barometer = 4,
+};
+
+/** A single sample of an inertial or environmental sensor. */
+struct SensorSample
+{
+    /** Kind of the sensor. */
+    SensorType type = SensorType::Accelerometer;
+    /** Time of the sample in seconds, on the same clock as beacon samples. */
+    double timestamp = 0.0;
+    /** X axis value. */
+    float x = 0.0f;
+    /** Y axis value. */
+    float y = 0.0f;
+    /** Z axis value. */
+    float z = 0.0f;
+};
+
+} // namespace eil
@@ -0,0 +1,178 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/AlgorithmParameters.hpp"
+#include "EILCore/Location.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eil {
+
+class SignalMap;
+
+/** Shared, immutable signal map. */
+typedef std::shared_ptr<const SignalMap> SignalMapRef;
+
+/**
+ * Precomputed grid of the RSSI expected from every beacon of a location.
+ *
+ * The grid spans the bounding box of the location with square cells of `AlgorithmParameters::signalMapCellSize`.
+ * Each cell holds the expected RSSI of all beacons next to each other, quantized to 0.5 dB, so evaluating the signal
+ * model for a position costs a single lookup per beacon instead of a logarithm. Every position within a cell gets the
+ * value of the cell center. With the default model and 0.5 m cells that is off by up to about 3.5 dB a meter away from
+ * a beacon and by less than 1 dB beyond four meters; the quantization adds at most 0.25 dB. The error stays below
+ * `AlgorithmParameters::rssiNoise` but is not negligible next to beacons, so venues with closely spaced beacons should
+ * use smaller cells.
+ *
+ * Maps loaded from a file are memory-mapped, so a large venue costs neither parsing time nor private memory.
+ * Immutable and thread-safe once created.
+ */
+class SignalMap
+{
+public:
+    ~SignalMap();
+
+    SignalMap(const SignalMap &) = delete;
+    SignalMap &operator=(const SignalMap &) = delete;
+
+    /**
+     * Computes the signal map of the location.
+     *
+     * @param location The location.
+     * @param parameters Parameters of the signal model and the cell size.
+     * @return The map or `nullptr` if the parameters describe no valid grid.
+     */
+    static SignalMapRef build(const Location &location, const AlgorithmParameters &parameters);
+
+    /**
+     * Maps a signal map file into memory.
+     *
+     * @param path Path of the file written by `save`.
+     * @param location The location the map is expected to describe.
+     * @param parameters Parameters the map is expected to be computed with.
+     * @return The map or `nullptr` if the file is missing, malformed, or was computed for a different location or parameters.
+     */
+    static SignalMapRef load(const std::string &path, const Location &location, const AlgorithmParameters &parameters);
+
+    /**
+     * Writes the map to a file. The file is replaced atomically.
+     *
+     * @param path Path of the file.
+     * @return true on success.
+     */
+    bool save(const std::string &path) const;
+
+    /**
+     * Whether the map describes the location and was computed with the parameters.
+     *
+     * @param location The location.
+     * @param parameters Parameters of the positioning algorithm.
+     */
+    bool matches(const Location &location, const AlgorithmParameters &parameters) const;
+
+    /**
+     * Returns the cell containing the point. Points outside of the grid are assigned to the nearest border cell.
+     *
+     * @param x X coordinate of the point.
+     * @param y Y coordinate of the point.
+     * @return Index of the cell.
+     */
+    size_t cellIndex(double x, double y) const
+    {
+        double column = (x - _originX) * _inverseCellSize;
+        double row = (y - _originY) * _inverseCellSize;
+        size_t c = column <= 0.0 ? 0 : std::min(static_cast<size_t>(column), _columns - 1);
+        size_t r = row <= 0.0 ? 0 : std::min(static_cast<size_t>(row), _rows - 1);
+        return r * _columns + c;
+    }
+
+    /**
+     * Returns the expected RSSI of a beacon within a cell.
+     *
+     * @param cell Index of the cell, see `cellIndex`.
+     * @param beaconIndex Index of the beacon in `Location::beacons`.
+     * @return Expected RSSI, in dBm.
+     */
+    double expectedRssi(size_t cell, size_t beaconIndex) const
+    {
+        return _data[cell * _beaconCount + beaconIndex] * -0.5;
+    }
+
+    /** Number of beacons per cell. */
+    size_t beaconCount() const { return _beaconCount; }
+
+    /** Number of cells of the grid. */
+    size_t cellCount() const { return _columns * _rows; }
+
+    /** Whether the map is backed by a memory-mapped file. */
+    bool isMapped() const { return _mapping != nullptr; }
+
+private:
+    SignalMap() = default;
+
+    uint64_t _fingerprint = 0;
+    double _measuredPower = 0.0;
+    double _pathLossExponent = 0.0;
+    double _cellSize = 0.0;
+    double _inverseCellSize = 0.0;
+    double _originX = 0.0;
+    double _originY = 0.0;
+    size_t _columns = 0;
+    size_t _rows = 0;
+    size_t _beaconCount = 0;
+
+    // Quantized expected RSSI, cell-major; points either into `_ownedData` or into `_mapping`.
+    const uint8_t *_data = nullptr;
+    std::vector<uint8_t> _ownedData;
+    void *_mapping = nullptr;
+    size_t _mappingLength = 0;
+};
+
+/**
+ * On-disk cache of signal maps, one file per location identifier and content.
+ *
+ * Files are versioned and keyed by the fingerprint of the location and a hash of the signal model parameters, so an
+ * edited location or changed parameters simply produce a new map instead of a wrong one, and engines with different
+ * parameters keep separate maps. Not thread-safe.
+ */
+class SignalMapCache
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param directory Existing directory in which maps are stored.
+     */
+    explicit SignalMapCache(std::string directory);
+
+    /**
+     * Returns the signal map of the location. It is mapped from the cache if present, otherwise it is computed and stored.
+     *
+     * @param location The location.
+     * @param parameters Parameters of the positioning algorithm.
+     * @return The map or `nullptr` if no map can be computed for the location.
+     */
+    SignalMapRef signalMapForLocation(const Location &location, const AlgorithmParameters &parameters);
+
+    /**
+     * Path of the file the map of the location is stored in.
+     *
+     * @param location The location.
+     * @param parameters Parameters of the positioning algorithm; the signal model and the cell size are part of the name.
+     */
+    std::string pathForLocation(const Location &location, const AlgorithmParameters &parameters) const;
+
+private:
+    std::string _directory;
+    // Maps handed out so far, so engines positioning in the same location share a single mapping.
+    std::unordered_map<std::string, std::weak_ptr<const SignalMap>> _maps;
+};
+
+} // namespace eil
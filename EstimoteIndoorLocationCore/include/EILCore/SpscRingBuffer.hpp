@@ -0,0 +1,111 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace eil {
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * Neither side ever blocks or allocates: pushing into a full buffer fails right away, popping from an empty one too.
+ * Indices of both sides live on separate cache lines, and each side caches the index of the other one, so the
+ * cache lines only bounce when the buffer looks full or empty.
+ */
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param capacity Minimum number of elements the buffer holds; rounded up to a power of two.
+     */
+    explicit SpscRingBuffer(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        _slots.resize(size);
+        _mask = size - 1;
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    /**
+     * Appends an element. Must only be called from the producer thread.
+     *
+     * @param value The element.
+     * @return false if the buffer is full; the element is not appended.
+     */
+    bool tryPush(const T &value)
+    {
+        size_t tail = _producer.index.load(std::memory_order_relaxed);
+        if (tail - _producer.cachedIndex > _mask)
+        {
+            _producer.cachedIndex = _consumer.index.load(std::memory_order_acquire);
+            if (tail - _producer.cachedIndex > _mask)
+            {
+                return false;
+            }
+        }
+        _slots[tail & _mask] = value;
+        _producer.index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes the oldest element. Must only be called from the consumer thread.
+     *
+     * @param value Receives the element.
+     * @return false if the buffer is empty.
+     */
+    bool tryPop(T &value)
+    {
+        size_t head = _consumer.index.load(std::memory_order_relaxed);
+        if (head == _consumer.cachedIndex)
+        {
+            _consumer.cachedIndex = _producer.index.load(std::memory_order_acquire);
+            if (head == _consumer.cachedIndex)
+            {
+                return false;
+            }
+        }
+        value = _slots[head & _mask];
+        _consumer.index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Number of elements the buffer holds. */
+    size_t capacity() const { return _mask + 1; }
+
+    /** Number of elements in the buffer. Only a hint while the other side is running. */
+    size_t size() const
+    {
+        return _producer.index.load(std::memory_order_acquire) - _consumer.index.load(std::memory_order_acquire);
+    }
+
+private:
+    /** State written by one side only, kept off the cache lines of the other side by the leading padding. */
+    struct Side
+    {
+        char padding[64];
+        /** Index of the next element to pop for the consumer, or to push for the producer. */
+        std::atomic<size_t> index{0};
+        /** Last seen index of the other side. */
+        size_t cachedIndex = 0;
+    };
+
+    std::vector<T> _slots;
+    size_t _mask = 0;
+    Side _consumer;
+    Side _producer;
+};
+
+} // namespace eil
@@ -0,0 +1,97 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/AlgorithmParameters.hpp"
+#include "EILCore/Location.hpp"
+#include "EILCore/PositioningEngine.hpp"
+
+#include <memory>
+#include <string>
+
+namespace eil {
+
+/** Outcome of replaying a scan trace. */
+struct TraceReplayStatistics
+{
+    /** Number of beacon samples fed into the engine. */
+    size_t beaconSamples = 0;
+    /** Number of sensor samples fed into the engine. */
+    size_t sensorSamples = 0;
+    /** Number of position updates delivered by the engine. */
+    size_t positionUpdates = 0;
+    /** Time span of the trace, in seconds. */
+    double traceDuration = 0.0;
+    /** Wall clock time spent inside the engine, in seconds. */
+    double wallTime = 0.0;
+    /** Processor time spent inside the engine, in seconds. */
+    double cpuTime = 0.0;
+    /** Whether the trace ended with an incomplete record. */
+    bool truncated = false;
+
+    /** Processor time per position update, in seconds. */
+    double cpuTimePerUpdate() const { return positionUpdates == 0 ? 0.0 : cpuTime / positionUpdates; }
+
+    /** How many times faster than real time the trace was replayed. */
+    double speedup() const { return wallTime > 0.0 ? traceDuration / wallTime : 0.0; }
+};
+
+/**
+ * Feeds a recorded scan trace through the positioning engine as fast as possible.
+ *
+ * Only the time spent inside the engine is measured; it includes the position handler but not reading the trace.
+ */
+class TraceReplayer
+{
+public:
+    /**
+     * Designated initializer.
+     *
+     * @param parameters Parameters of the positioning algorithm used for the replay.
+     */
+    explicit TraceReplayer(const AlgorithmParameters &parameters = AlgorithmParameters()) : _parameters(parameters) {}
+
+    /**
+     * Sets the block invoked with every position update produced during the replay.
+     *
+     * @param handler The block. Can be empty.
+     */
+    void setPositionHandler(PositioningEngine::PositionHandler handler) { _positionHandler = std::move(handler); }
+
+    /**
+     * Sets the cache of precomputed signal maps used by the engine during the replay.
+     *
+     * @param cache The cache or `nullptr` to evaluate the signal model directly.
+     */
+    void setSignalMapCache(std::shared_ptr<SignalMapCache> cache) { _signalMapCache = std::move(cache); }
+
+    /**
+     * Sets the step length of the user for traces recorded in the inertial positioning mode. Sensor samples of the
+     * trace are fused in step with its beacon samples, as `InertialFusion` would have fused them during the recording.
+     *
+     * @param stepLength Average step length of the user, in meters; the one used during the recording.
+     */
+    void setInertialStepLength(double stepLength) { _inertialStepLength = stepLength; }
+
+    /**
+     * Replays the trace.
+     *
+     * @param path Path of the trace file.
+     * @param location Location to position in. If `nullptr`, the locations recorded in the trace are started and stopped
+     *                 as during the recording.
+     * @return false if the trace could not be opened or contains no location to position in.
+     */
+    bool replay(const std::string &path, LocationRef location = nullptr);
+
+    /** Statistics of the most recent replay. */
+    const TraceReplayStatistics &statistics() const { return _statistics; }
+
+private:
+    AlgorithmParameters _parameters;
+    PositioningEngine::PositionHandler _positionHandler;
+    std::shared_ptr<SignalMapCache> _signalMapCache;
+    double _inertialStepLength = 0.7;
+    TraceReplayStatistics _statistics;
+};
+
+} // namespace eil
@@ -0,0 +1,115 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include "EILCore/Geometry.hpp"
+#include "EILCore/Location.hpp"
+#include "EILCore/Random.hpp"
+
+#include <cstddef>
+
+namespace eil {
+
+/**
+ * Rotated and translated view of a location.
+ *
+ * Shares the immutable geometry of the base location and applies the transform to every coordinate on access, so
+ * creating a view costs the same for a studio and for a mall. Identifiers, names and types of beacons, linear objects
+ * and pins are read from `base()`; only their positions are transformed. Point queries such as `containsPoint` map the
+ * point into the base location and reuse its lazily built acceleration structures.
+ *
+ * Views are small values. Transforming a view composes the transforms instead of stacking views.
+ */
+class TransformedLocation
+{
+public:
+    /**
+     * Creates a view.
+     *
+     * @param location Base location. Must not be null.
+     * @param transform Transform from coordinates of the base location to coordinates of the view.
+     */
+    TransformedLocation(LocationRef location, const RigidTransform &transform);
+
+    /** Location the view is based on. */
+    const LocationRef &base() const { return _location; }
+
+    /** Transform from coordinates of the base location to coordinates of the view. */
+    const RigidTransform &transform() const { return _transform; }
+
+    /**
+     * Transforms the view further.
+     *
+     * @param transform Transform applied after the current one.
+     * @return A view of the same base location.
+     */
+    TransformedLocation transformedBy(const RigidTransform &transform) const;
+
+    /** @see Location::translatedBy */
+    TransformedLocation translatedBy(double dX, double dY) const { return transformedBy(RigidTransform(dX, dY)); }
+
+    /** Maps a point of the base location into the view. */
+    Point fromBase(const Point &point) const { return _transform.apply(point); }
+
+    /** Maps a point of the view into the base location. */
+    Point toBase(const Point &point) const { return _inverse.apply(point); }
+
+    /** Number of boundary segments. */
+    size_t boundarySegmentCount() const { return _location->boundarySegments().size(); }
+
+    /** Boundary segment at a given index, transformed. */
+    OrientedLineSegment boundarySegment(size_t index) const
+    {
+        return _transform.apply(_location->boundarySegments()[index]);
+    }
+
+    /** Position of the beacon at a given index of `base()->beacons()`, transformed. */
+    OrientedPoint beaconPosition(size_t index) const { return _transform.apply(_location->beacons()[index].position); }
+
+    /** Position of the linear object at a given index of `base()->linearObjects()`, transformed. */
+    OrientedLineSegment linearObjectPosition(size_t index) const
+    {
+        return _transform.apply(_location->linearObjects()[index].position);
+    }
+
+    /** Position of the pin at a given index of `base()->locationPins()`, transformed. */
+    OrientedPoint locationPinPosition(size_t index) const
+    {
+        return _transform.apply(_location->locationPins()[index].position);
+    }
+
+    /** @see Location::orientation */
+    double orientation() const;
+
+    /** @see Location::area */
+    double area() const { return _location->area(); }
+
+    /** Bounding box of the transformed polygon. Computed on each call, in time linear in the number of vertices. */
+    Rect boundingBox() const;
+
+    /** @see Location::containsPoint */
+    bool containsPoint(double x, double y) const { return _location->containsPoint(toBase(Point(x, y))); }
+
+    /** @see Location::containsPoint */
+    bool containsPoint(const Point &point) const { return _location->containsPoint(toBase(point)); }
+
+    /** @see Location::randomPointInside */
+    Point randomPointInside(Random &random) const { return fromBase(_location->randomPointInside(random)); }
+
+    /** @see Location::randomPointsInside */
+    void randomPointsInside(Random &random, Point *points, size_t count) const;
+
+    /**
+     * Copies the transformed geometry into a standalone location, for APIs that take a `Location`.
+     *
+     * @return A new location equal to `base()->transformedBy(transform())`.
+     */
+    Location materialize() const { return _location->transformedBy(_transform); }
+
+private:
+    LocationRef _location;
+    RigidTransform _transform;
+    RigidTransform _inverse;
+};
+
+} // namespace eil
@@ -0,0 +1,72 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/BeaconFilterBank.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eil {
+
+BeaconFilterBank::BeaconFilterBank(double timeConstant)
+    : _timeConstant(timeConstant)
+{
+}
+
+void BeaconFilterBank::addSample(const BeaconSample &sample)
+{
+    BeaconState &state = _states[sample.beacon];
+    if (state.sampleCount == 0)
+    {
+        state.rssi = sample.rssi;
+        state.variance = 0.0;
+        state.firstSeen = sample.timestamp;
+        state.lastSeen = sample.timestamp;
+        state.sampleCount = 1;
+        return;
+    }
+
+    double elapsed = sample.timestamp - state.lastSeen;
+    double alpha = elapsed > 0.0 && _timeConstant > 0.0 ? 1.0 - std::exp(-elapsed / _timeConstant) : 1.0;
+    // Samples that arrive in the same instant are still taken into account, just with a small weight.
+    if (elapsed <= 0.0 && _timeConstant > 0.0)
+    {
+        alpha = 1.0 / (state.sampleCount + 1.0);
+    }
+
+    double delta = sample.rssi - state.rssi;
+    state.rssi += alpha * delta;
+    state.variance = (1.0 - alpha) * (state.variance + alpha * delta * delta);
+    state.lastSeen = std::max(state.lastSeen, sample.timestamp);
+    state.sampleCount++;
+}
+
+const BeaconState *BeaconFilterBank::stateForBeacon(BeaconId beacon) const
+{
+    auto it = _states.find(beacon);
+    return it == _states.end() ? nullptr : &it->second;
+}
+
+void BeaconFilterBank::restoreState(BeaconId beacon, const BeaconState &state)
+{
+    if (state.sampleCount > 0)
+    {
+        _states[beacon] = state;
+    }
+}
+
+void BeaconFilterBank::removeStaleBeacons(double timestamp, double timeout)
+{
+    for (auto it = _states.begin(); it != _states.end();)
+    {
+        if (timestamp - it->second.lastSeen > timeout)
+        {
+            it = _states.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+} // namespace eil
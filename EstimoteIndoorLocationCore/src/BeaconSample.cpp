@@ -0,0 +1,26 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/BeaconSample.hpp"
+
+#include <cctype>
+
+namespace eil {
+
+BeaconId beaconIdFromIdentifier(const std::string &identifier)
+{
+    // 64-bit FNV-1a.
+    BeaconId hash = 14695981039346656037ULL;
+    for (unsigned char c : identifier)
+    {
+        hash ^= static_cast<BeaconId>(std::tolower(c));
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+BeaconId beaconIdFromIBeacon(const std::string &proximityUUID, uint16_t major, uint16_t minor)
+{
+    return beaconIdFromIdentifier(proximityUUID + ":" + std::to_string(major) + ":" + std::to_string(minor));
+}
+
+} // namespace eil
@@ -0,0 +1,198 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace eil {
+
+/** Appends little-endian encoded values to a byte buffer. Private helper of the binary file formats. */
+class ByteWriter
+{
+public:
+    explicit ByteWriter(std::string &buffer) : _buffer(buffer) {}
+
+    void putUInt8(uint8_t value) { _buffer.push_back(static_cast<char>(value)); }
+
+    void putUInt16(uint16_t value)
+    {
+        putUInt8(static_cast<uint8_t>(value));
+        putUInt8(static_cast<uint8_t>(value >> 8));
+    }
+
+    void putUInt32(uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            putUInt8(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void putUInt64(uint64_t value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            putUInt8(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void putFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        putUInt32(bits);
+    }
+
+    void putDouble(double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        putUInt64(bits);
+    }
+
+    /** LEB128 variable length encoding. */
+    void putVarUInt(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            putUInt8(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        putUInt8(static_cast<uint8_t>(value));
+    }
+
+    /** Zig-zag encoded variable length signed integer. */
+    void putVarInt(int64_t value)
+    {
+        putVarUInt((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void putString(const std::string &value)
+    {
+        putVarUInt(value.size());
+        _buffer.append(value);
+    }
+
+private:
+    std::string &_buffer;
+};
+
+/**
+ * Reads little-endian encoded values from a byte range.
+ *
+ * Reading past the end does not crash; it puts the reader into a failed state and returns zeros instead.
+ */
+class ByteReader
+{
+public:
+    ByteReader(const uint8_t *bytes, size_t length) : _bytes(bytes), _length(length) {}
+
+    bool failed() const { return _failed; }
+    size_t offset() const { return _offset; }
+    size_t remaining() const { return _length - _offset; }
+
+    uint8_t getUInt8()
+    {
+        if (!require(1))
+        {
+            return 0;
+        }
+        return _bytes[_offset++];
+    }
+
+    uint16_t getUInt16()
+    {
+        uint16_t low = getUInt8();
+        return static_cast<uint16_t>(low | (getUInt8() << 8));
+    }
+
+    uint32_t getUInt32()
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            value |= static_cast<uint32_t>(getUInt8()) << (8 * i);
+        }
+        return value;
+    }
+
+    uint64_t getUInt64()
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            value |= static_cast<uint64_t>(getUInt8()) << (8 * i);
+        }
+        return value;
+    }
+
+    float getFloat()
+    {
+        uint32_t bits = getUInt32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    double getDouble()
+    {
+        uint64_t bits = getUInt64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint64_t getVarUInt()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = getUInt8();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0 || _failed)
+            {
+                return value;
+            }
+        }
+        _failed = true;
+        return 0;
+    }
+
+    int64_t getVarInt()
+    {
+        uint64_t value = getVarUInt();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    std::string getString()
+    {
+        uint64_t length = getVarUInt();
+        if (!require(length))
+        {
+            return std::string();
+        }
+        std::string value(reinterpret_cast<const char *>(_bytes + _offset), static_cast<size_t>(length));
+        _offset += static_cast<size_t>(length);
+        return value;
+    }
+
+private:
+    bool require(uint64_t count)
+    {
+        if (_failed || count > _length - _offset)
+        {
+            _failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t *_bytes;
+    size_t _length;
+    size_t _offset = 0;
+    bool _failed = false;
+};
+
+} // namespace eil
@@ -0,0 +1,62 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/Building.hpp"
+
+#include <algorithm>
+
+namespace eil {
+
+Building::Building(std::string identifier, std::vector<Floor> floors, double floorHeight)
+    : _identifier(std::move(identifier)), _floorHeight(floorHeight)
+{
+    for (Floor &floor : floors)
+    {
+        if (floor.location)
+        {
+            _floors.push_back(std::move(floor));
+        }
+    }
+    std::stable_sort(_floors.begin(), _floors.end(), [](const Floor &a, const Floor &b) { return a.level < b.level; });
+
+    for (size_t i = 0; i < _floors.size(); i++)
+    {
+        for (const PositionedBeacon &beacon : _floors[i].location->beacons())
+        {
+            _floorsByBeacon.emplace(beacon.beacon, static_cast<int>(i));
+        }
+    }
+}
+
+int Building::indexOfLevel(int level) const
+{
+    for (size_t i = 0; i < _floors.size(); i++)
+    {
+        if (_floors[i].level == level)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int Building::indexOfLocation(const Location &location) const
+{
+    for (size_t i = 0; i < _floors.size(); i++)
+    {
+        const Location &floorLocation = *_floors[i].location;
+        if (&floorLocation == &location
+            || (!location.identifier().empty() && floorLocation.identifier() == location.identifier()))
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int Building::floorIndexOfBeacon(BeaconId beacon) const
+{
+    auto it = _floorsByBeacon.find(beacon);
+    return it == _floorsByBeacon.end() ? -1 : it->second;
+}
+
+} // namespace eil
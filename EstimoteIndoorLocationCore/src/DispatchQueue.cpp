@@ -0,0 +1,59 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/DispatchQueue.hpp"
+
+namespace eil {
+
+SerialDispatchQueue::SerialDispatchQueue()
+    : _thread(&SerialDispatchQueue::run, this)
+{
+}
+
+SerialDispatchQueue::~SerialDispatchQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_all();
+    _thread.join();
+}
+
+void SerialDispatchQueue::async(std::function<void()> block)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _blocks.push_back(std::move(block));
+    }
+    _condition.notify_all();
+}
+
+void SerialDispatchQueue::waitUntilIdle()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [this] { return _blocks.empty() && !_executing; });
+}
+
+void SerialDispatchQueue::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        _condition.wait(lock, [this] { return _stopping || !_blocks.empty(); });
+        if (_blocks.empty())
+        {
+            return;
+        }
+
+        std::function<void()> block = std::move(_blocks.front());
+        _blocks.pop_front();
+        _executing = true;
+        lock.unlock();
+        block();
+        lock.lock();
+        _executing = false;
+        _condition.notify_all();
+    }
+}
+
+} // namespace eil
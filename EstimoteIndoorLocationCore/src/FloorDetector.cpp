@@ -0,0 +1,187 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/FloorDetector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace eil {
+
+namespace {
+
+/** Scale height of the lower atmosphere, in meters; altitude difference is this times the log of the pressure ratio. */
+constexpr double kScaleHeight = 8434.5;
+
+/** Fraction of a storey the altitude has to change by to point at another floor. */
+constexpr double kStoreyChangeFraction = 0.5;
+
+/** Fraction of a storey within which the altitude counts as unchanged. */
+constexpr double kSteadyAltitudeFraction = 0.25;
+
+/** Time constant with which the reference pressure follows weather while the altitude is unchanged, in seconds. */
+constexpr double kPressureDriftTimeConstant = 120.0;
+
+} // namespace
+
+FloorDetector::FloorDetector(BuildingRef building, double switchMargin, double dwellTime, size_t strongestBeaconCount)
+    : _building(std::move(building)),
+      _switchMargin(switchMargin),
+      _dwellTime(dwellTime),
+      _strongestBeaconCount(std::max<size_t>(strongestBeaconCount, 1))
+{
+    size_t floorCount = _building->floors().size();
+    _scores.resize(floorCount);
+    _strongest.resize(floorCount * _strongestBeaconCount);
+    _strongestCounts.resize(floorCount);
+}
+
+void FloorDetector::reset()
+{
+    _currentFloor = -1;
+    _candidateFloor = -1;
+    _referencePressure = 0.0;
+    _lastUpdate = 0.0;
+}
+
+void FloorDetector::scoreFloors(double timestamp, const BeaconFilterBank &beacons, double beaconTimeout)
+{
+    std::fill(_strongestCounts.begin(), _strongestCounts.end(), 0);
+    for (const auto &entry : beacons.states())
+    {
+        if (timestamp - entry.second.lastSeen > beaconTimeout)
+        {
+            continue;
+        }
+        int floor = _building->floorIndexOfBeacon(entry.first);
+        if (floor < 0)
+        {
+            continue;
+        }
+
+        // Insertion into the short list of strongest values of the floor, dropping the weakest when it is full.
+        double *strongest = &_strongest[floor * _strongestBeaconCount];
+        size_t &count = _strongestCounts[floor];
+        double rssi = entry.second.rssi;
+        if (count == _strongestBeaconCount && rssi <= strongest[count - 1])
+        {
+            continue;
+        }
+        size_t position = count < _strongestBeaconCount ? count++ : count - 1;
+        while (position > 0 && strongest[position - 1] < rssi)
+        {
+            strongest[position] = strongest[position - 1];
+            position--;
+        }
+        strongest[position] = rssi;
+    }
+
+    for (size_t floor = 0; floor < _scores.size(); floor++)
+    {
+        size_t count = _strongestCounts[floor];
+        if (count == 0)
+        {
+            _scores[floor] = -std::numeric_limits<double>::infinity();
+            continue;
+        }
+        const double *strongest = &_strongest[floor * _strongestBeaconCount];
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            sum += strongest[i];
+        }
+        _scores[floor] = sum / count;
+    }
+}
+
+bool FloorDetector::update(double timestamp, const BeaconFilterBank &beacons, double beaconTimeout,
+                           const MotionState *motion)
+{
+    if (_scores.empty())
+    {
+        return false;
+    }
+    scoreFloors(timestamp, beacons, beaconTimeout);
+    int best = static_cast<int>(std::max_element(_scores.begin(), _scores.end()) - _scores.begin());
+    double pressure = motion != nullptr ? motion->pressure : 0.0;
+    double elapsed = _lastUpdate > 0.0 ? std::max(timestamp - _lastUpdate, 0.0) : 0.0;
+    _lastUpdate = timestamp;
+
+    if (_currentFloor < 0)
+    {
+        if (_scores[best] == -std::numeric_limits<double>::infinity())
+        {
+            return false;
+        }
+        changeFloor(best, timestamp, pressure);
+        return true;
+    }
+
+    // Altitude change since the current floor was entered points at a floor, or confirms staying.
+    int pressureFloor = -1;
+    bool steadyAltitude = false;
+    if (pressure > 0.0 && _referencePressure > 0.0)
+    {
+        double altitudeChange = kScaleHeight * std::log(_referencePressure / pressure);
+        double storeys = altitudeChange / _building->floorHeight();
+        if (std::abs(storeys) >= kStoreyChangeFraction)
+        {
+            int level = _building->floors()[_currentFloor].level + static_cast<int>(std::lround(storeys));
+            pressureFloor = _building->indexOfLevel(level);
+        }
+        else if (std::abs(storeys) < kSteadyAltitudeFraction)
+        {
+            steadyAltitude = true;
+            _referencePressure += (pressure - _referencePressure) * std::min(elapsed / kPressureDriftTimeConstant, 1.0);
+        }
+    }
+    else if (pressure > 0.0)
+    {
+        _referencePressure = pressure;
+    }
+
+    // A floor nobody heard never takes over, even from a current floor that went silent as well.
+    const double unheard = -std::numeric_limits<double>::infinity();
+    double current = _scores[_currentFloor];
+    double margin = steadyAltitude ? 2.0 * _switchMargin : _switchMargin;
+    int candidate = -1;
+    if (pressureFloor >= 0 && pressureFloor != _currentFloor && _scores[pressureFloor] != unheard
+        && _scores[pressureFloor] >= current - _switchMargin)
+    {
+        candidate = pressureFloor;
+    }
+    else if (best != _currentFloor && _scores[best] != unheard && _scores[best] >= current + margin)
+    {
+        candidate = best;
+    }
+
+    if (candidate < 0)
+    {
+        _candidateFloor = -1;
+        return false;
+    }
+    if (candidate != _candidateFloor)
+    {
+        _candidateFloor = candidate;
+        _candidateSince = timestamp;
+    }
+    if (timestamp - _candidateSince < _dwellTime)
+    {
+        return false;
+    }
+    changeFloor(candidate, timestamp, pressure);
+    return true;
+}
+
+void FloorDetector::changeFloor(int floor, double timestamp, double pressure)
+{
+    _currentFloor = floor;
+    _candidateFloor = -1;
+    _referencePressure = pressure;
+    if (_floorChangeHandler)
+    {
+        _floorChangeHandler(_building->floors()[floor], timestamp);
+    }
+}
+
+} // namespace eil
@@ -0,0 +1,297 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/GeofenceMonitor.hpp"
+
+#include <algorithm>
+
+namespace eil {
+
+GeofenceMonitor::GeofenceMonitor(double exitTimeout, int minimumRssi)
+    : _exitTimeout(exitTimeout),
+      _minimumRssi(minimumRssi)
+{
+}
+
+void GeofenceMonitor::setStateHandler(StateHandler handler)
+{
+    _stateHandler = handler ? std::make_shared<const StateHandler>(std::move(handler)) : nullptr;
+}
+
+bool GeofenceMonitor::startMonitoring(LocationRef location)
+{
+    if (!location || _regionsByIdentifier.count(location->identifier()) > 0)
+    {
+        return false;
+    }
+
+    size_t index;
+    if (!_freeRegions.empty())
+    {
+        index = _freeRegions.back();
+        _freeRegions.pop_back();
+    }
+    else
+    {
+        index = _regions.size();
+        _regions.emplace_back();
+    }
+
+    Region &region = _regions[index];
+    region.location = std::move(location);
+    region.state = LocationState::Unknown;
+    region.lastHeard = 0.0;
+    region.isActive = true;
+    region.hasDeadline = false;
+    _regionsByIdentifier[region.location->identifier()] = index;
+    for (BeaconId beacon : beaconIdsOfLocation(*region.location))
+    {
+        _regionsByBeacon[beacon].push_back(index);
+    }
+    // The clock is only known once the next sample or `advanceTo` arrives.
+    _pendingRegions.push_back(index);
+    return true;
+}
+
+void GeofenceMonitor::stopMonitoring(const Location &location)
+{
+    auto found = _regionsByIdentifier.find(location.identifier());
+    if (found == _regionsByIdentifier.end())
+    {
+        return;
+    }
+
+    size_t index = found->second;
+    Region &region = _regions[index];
+    for (BeaconId beacon : beaconIdsOfLocation(*region.location))
+    {
+        auto regions = _regionsByBeacon.find(beacon);
+        if (regions == _regionsByBeacon.end())
+        {
+            continue;
+        }
+        std::vector<size_t> &indices = regions->second;
+        indices.erase(std::remove(indices.begin(), indices.end(), index), indices.end());
+        if (indices.empty())
+        {
+            _regionsByBeacon.erase(regions);
+        }
+    }
+    _regionsByIdentifier.erase(found);
+
+    region.location.reset();
+    region.isActive = false;
+    region.hasDeadline = false;
+    region.generation++;
+    _freeRegions.push_back(index);
+}
+
+LocationState GeofenceMonitor::stateForLocationWithIdentifier(const std::string &identifier) const
+{
+    auto found = _regionsByIdentifier.find(identifier);
+    return found != _regionsByIdentifier.end() ? _regions[found->second].state : LocationState::Unknown;
+}
+
+std::vector<LocationRef> GeofenceMonitor::monitoredLocations() const
+{
+    std::vector<LocationRef> locations;
+    locations.reserve(_regionsByIdentifier.size());
+    for (const Region &region : _regions)
+    {
+        if (region.isActive)
+        {
+            locations.push_back(region.location);
+        }
+    }
+    return locations;
+}
+
+void GeofenceMonitor::processSample(const BeaconSample &sample)
+{
+    startPendingRegions(sample.timestamp);
+    expireRegions(sample.timestamp);
+    auto found = _regionsByBeacon.find(sample.beacon);
+    if (sample.rssi < _minimumRssi || found == _regionsByBeacon.end())
+    {
+        deliverDueStateChanges(sample.timestamp);
+        return;
+    }
+
+    _affectedRegions.clear();
+    for (size_t index : found->second)
+    {
+        _affectedRegions.emplace_back(index, _regions[index].generation);
+    }
+    for (const std::pair<size_t, uint32_t> &affected : _affectedRegions)
+    {
+        size_t index = affected.first;
+        Region &region = _regions[index];
+        if (!region.isActive || region.generation != affected.second)
+        {
+            continue;
+        }
+        region.lastHeard = std::max(region.lastHeard, sample.timestamp);
+        if (!region.hasDeadline)
+        {
+            scheduleDeadline(index);
+        }
+        if (region.state != LocationState::Inside)
+        {
+            setState(index, LocationState::Inside, sample.timestamp);
+        }
+    }
+    deliverDueStateChanges(sample.timestamp);
+}
+
+void GeofenceMonitor::advanceTo(double timestamp)
+{
+    startPendingRegions(timestamp);
+    expireRegions(timestamp);
+    deliverDueStateChanges(timestamp);
+}
+
+void GeofenceMonitor::setMaximumDeliveryLatency(double latency)
+{
+    _maximumDeliveryLatency = latency;
+    if (_maximumDeliveryLatency <= 0.0)
+    {
+        flushStateChanges();
+    }
+}
+
+void GeofenceMonitor::flushStateChanges()
+{
+    // A handler flushing again, e.g. through the engine, finds nothing left to hand over.
+    if (_pendingStateChanges.empty() || !_deliveredStateChanges.empty())
+    {
+        return;
+    }
+    if (_delegateQueue)
+    {
+        std::shared_ptr<const StateHandler> handler = _stateHandler;
+        std::vector<StateChange> changes;
+        takeStateChanges(changes);
+        if (handler)
+        {
+            _delegateQueue->async([handler, changes] {
+                for (const StateChange &change : changes)
+                {
+                    (*handler)(change.state, *change.location);
+                }
+            });
+        }
+        return;
+    }
+    _deliveredStateChanges.swap(_pendingStateChanges);
+    for (const StateChange &change : _deliveredStateChanges)
+    {
+        // Kept alive locally, the handler may replace itself.
+        std::shared_ptr<const StateHandler> handler = _stateHandler;
+        if (handler)
+        {
+            (*handler)(change.state, *change.location);
+        }
+    }
+    _deliveredStateChanges.clear();
+}
+
+void GeofenceMonitor::takeStateChanges(std::vector<StateChange> &changes)
+{
+    changes.clear();
+    changes.swap(_pendingStateChanges);
+}
+
+std::vector<BeaconId> GeofenceMonitor::beaconIdsOfLocation(const Location &location) const
+{
+    std::vector<BeaconId> beacons;
+    beacons.reserve(location.beacons().size());
+    for (const PositionedBeacon &beacon : location.beacons())
+    {
+        beacons.push_back(beacon.beacon);
+        if (!beacon.proximityUUID.empty() && beacon.major >= 0 && beacon.minor >= 0)
+        {
+            beacons.push_back(beaconIdFromIBeacon(beacon.proximityUUID, static_cast<uint16_t>(beacon.major),
+                                                  static_cast<uint16_t>(beacon.minor)));
+        }
+    }
+    // A beacon listed twice must not index the location twice.
+    std::sort(beacons.begin(), beacons.end());
+    beacons.erase(std::unique(beacons.begin(), beacons.end()), beacons.end());
+    return beacons;
+}
+
+void GeofenceMonitor::startPendingRegions(double timestamp)
+{
+    for (size_t index : _pendingRegions)
+    {
+        Region &region = _regions[index];
+        if (region.isActive && !region.hasDeadline)
+        {
+            region.lastHeard = timestamp;
+            scheduleDeadline(index);
+        }
+    }
+    _pendingRegions.clear();
+}
+
+void GeofenceMonitor::expireRegions(double timestamp)
+{
+    while (!_deadlines.empty() && _deadlines.top().timestamp <= timestamp)
+    {
+        Deadline deadline = _deadlines.top();
+        _deadlines.pop();
+        Region &region = _regions[deadline.region];
+        if (!region.isActive || region.generation != deadline.generation)
+        {
+            continue;
+        }
+
+        // Samples only move `lastHeard` forward; the deadline is moved lazily when it comes due.
+        region.hasDeadline = false;
+        if (region.lastHeard + _exitTimeout > timestamp)
+        {
+            scheduleDeadline(deadline.region);
+        }
+        else if (region.state != LocationState::Outside)
+        {
+            setState(deadline.region, LocationState::Outside, timestamp);
+        }
+    }
+}
+
+void GeofenceMonitor::scheduleDeadline(size_t index)
+{
+    Region &region = _regions[index];
+    region.hasDeadline = true;
+    _deadlines.push(Deadline{region.lastHeard + _exitTimeout, index, region.generation});
+}
+
+void GeofenceMonitor::setState(size_t index, LocationState state, double timestamp)
+{
+    _regions[index].state = state;
+    if (_maximumDeliveryLatency > 0.0)
+    {
+        _pendingStateChanges.push_back(StateChange{timestamp, state, _regions[index].location});
+    }
+    else if (_stateHandler)
+    {
+        // Keeps the location alive even if the handler stops monitoring it.
+        LocationRef location = _regions[index].location;
+        std::shared_ptr<const StateHandler> handler = _stateHandler;
+        if (_delegateQueue)
+        {
+            _delegateQueue->async([handler, state, location] { (*handler)(state, *location); });
+            return;
+        }
+        (*handler)(state, *location);
+    }
+}
+
+void GeofenceMonitor::deliverDueStateChanges(double timestamp)
+{
+    if (!_pendingStateChanges.empty() && timestamp - _pendingStateChanges.front().timestamp >= _maximumDeliveryLatency)
+    {
+        flushStateChanges();
+    }
+}
+
+} // namespace eil
@@ -0,0 +1,108 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/Geometry.hpp"
+
+#include <algorithm>
+
+namespace eil {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+double normalizedAngle(double angle)
+{
+    double normalized = std::fmod(angle, 360.0);
+    return normalized < 0.0 ? normalized + 360.0 : normalized;
+}
+
+} // namespace
+
+Point Point::rotatedAround(const Point &center, double angle) const
+{
+    double radians = angle * kPi / 180.0;
+    double cosine = std::cos(radians);
+    double sine = std::sin(radians);
+    double dX = x - center.x;
+    double dY = y - center.y;
+    return Point(center.x + dX * cosine + dY * sine, center.y - dX * sine + dY * cosine);
+}
+
+OrientedPoint OrientedPoint::rotatedAround(const Point &center, double angle) const
+{
+    Point rotated = Point::rotatedAround(center, angle);
+    if (!hasOrientation())
+    {
+        return OrientedPoint(rotated);
+    }
+    double rotatedOrientation = std::fmod(orientation + angle, 360.0);
+    return OrientedPoint(rotated, rotatedOrientation < 0.0 ? rotatedOrientation + 360.0 : rotatedOrientation);
+}
+
+RigidTransform::RigidTransform(double dX, double dY, double angle) : _dX(dX), _dY(dY), _angle(normalizedAngle(angle))
+{
+    // Pure translations keep an exact identity rotation, so they give the same coordinates as `translatedBy`.
+    if (_angle != 0.0)
+    {
+        double radians = _angle * kPi / 180.0;
+        _cosine = std::cos(radians);
+        _sine = std::sin(radians);
+    }
+}
+
+RigidTransform RigidTransform::rotationAround(const Point &center, double angle)
+{
+    Point rotatedOrigin = Point().rotatedAround(center, angle);
+    return RigidTransform(rotatedOrigin.x, rotatedOrigin.y, angle);
+}
+
+double RigidTransform::applyToOrientation(double orientation) const
+{
+    if (orientation == kOrientationUndefined || _angle == 0.0)
+    {
+        return orientation;
+    }
+    return normalizedAngle(orientation + _angle);
+}
+
+RigidTransform RigidTransform::followedBy(const RigidTransform &next) const
+{
+    Point translation = next.apply(Point(_dX, _dY));
+    return RigidTransform(translation.x, translation.y, _angle + next._angle);
+}
+
+RigidTransform RigidTransform::inverse() const
+{
+    RigidTransform rotation(0.0, 0.0, -_angle);
+    Point translation = rotation.apply(Point(-_dX, -_dY));
+    return RigidTransform(translation.x, translation.y, -_angle);
+}
+
+double OrientedLineSegment::distanceTo(const Point &point) const
+{
+    double dX = point2.x - point1.x;
+    double dY = point2.y - point1.y;
+    double lengthSquared = dX * dX + dY * dY;
+    if (lengthSquared == 0.0)
+    {
+        return point.distanceTo(point1);
+    }
+
+    double t = ((point.x - point1.x) * dX + (point.y - point1.y) * dY) / lengthSquared;
+    t = std::max(0.0, std::min(1.0, t));
+    return point.distanceTo(Point(point1.x + t * dX, point1.y + t * dY));
+}
+
+Point directionForOrientation(double orientation)
+{
+    double radians = orientation * kPi / 180.0;
+    return Point(std::sin(radians), std::cos(radians));
+}
+
+double orientationForDirection(double dX, double dY)
+{
+    double degrees = std::atan2(dX, dY) * 180.0 / kPi;
+    return degrees < 0.0 ? degrees + 360.0 : degrees;
+}
+
+} // namespace eil
@@ -0,0 +1,195 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/InertialFusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eil {
+
+namespace {
+
+/** Time constant of the smoothing of the acceleration magnitude, in seconds. */
+constexpr double kAccelerationTimeConstant = 0.05;
+/** Smoothed user acceleration above which a step is counted, in g. */
+constexpr double kStepThreshold = 0.12;
+/** Smoothed user acceleration below which the next step can be counted, in g. */
+constexpr double kStepResetThreshold = 0.05;
+/** Shortest time between two steps, in seconds. Faster peaks are part of the same step. */
+constexpr double kMinimumStepInterval = 0.25;
+/** Time after the last step after which the user is considered standing, in seconds. */
+constexpr double kStandingTimeout = 1.5;
+/** Window over which the step frequency is measured, in seconds. */
+constexpr double kStepFrequencyWindow = 2.5;
+
+} // namespace
+
+InertialFusion::InertialFusion(size_t capacity, double stepLength, bool startThread)
+    : _stepLength(stepLength)
+{
+    for (std::unique_ptr<SpscRingBuffer<SensorSample>> &stream : _streams)
+    {
+        stream.reset(new SpscRingBuffer<SensorSample>(capacity));
+    }
+    if (startThread)
+    {
+        _thread = std::thread(&InertialFusion::run, this);
+    }
+}
+
+InertialFusion::~InertialFusion()
+{
+    _stopping.store(true, std::memory_order_release);
+    _idle.store(false);
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _wakeCondition.notify_one();
+    }
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void InertialFusion::processPendingSamples()
+{
+    drain();
+}
+
+bool InertialFusion::pushSample(const SensorSample &sample)
+{
+    size_t stream = static_cast<size_t>(sample.type) - 1;
+    if (stream >= kStreamCount || !_streams[stream]->tryPush(sample))
+    {
+        _droppedSampleCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // Pairs with the fence in `run`: either the fusion thread sees the sample before it waits, or this sees it idle.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_idle.load(std::memory_order_relaxed))
+    {
+        wakeUp();
+    }
+    return true;
+}
+
+void InertialFusion::wakeUp()
+{
+    // Only one of several producers finding the thread idle takes the lock.
+    if (_idle.exchange(false))
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _wakeCondition.notify_one();
+    }
+}
+
+bool InertialFusion::hasPendingSamples() const
+{
+    for (const std::unique_ptr<SpscRingBuffer<SensorSample>> &stream : _streams)
+    {
+        if (stream->size() > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void InertialFusion::run()
+{
+    while (!_stopping.load(std::memory_order_acquire))
+    {
+        if (drain())
+        {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_wakeMutex);
+        _idle.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (hasPendingSamples() || _stopping.load(std::memory_order_acquire))
+        {
+            _idle.store(false);
+            continue;
+        }
+        _wakeCondition.wait(lock, [this] { return !_idle.load(); });
+    }
+    drain();
+}
+
+bool InertialFusion::drain()
+{
+    bool processed = false;
+    SensorSample sample;
+    for (std::unique_ptr<SpscRingBuffer<SensorSample>> &stream : _streams)
+    {
+        while (stream->tryPop(sample))
+        {
+            processed = true;
+            switch (sample.type)
+            {
+                case SensorType::Accelerometer:
+                    processAccelerometer(sample);
+                    break;
+                case SensorType::Barometer:
+                    _state.pressure = sample.x;
+                    break;
+                case SensorType::Gyroscope:
+                case SensorType::Magnetometer:
+                    break;
+            }
+        }
+    }
+    // Published once per batch rather than per sample; readers only need the latest state.
+    if (processed)
+    {
+        _motionState.store(_state);
+    }
+    return processed;
+}
+
+void InertialFusion::processAccelerometer(const SensorSample &sample)
+{
+    double magnitude = std::sqrt(static_cast<double>(sample.x) * sample.x + static_cast<double>(sample.y) * sample.y
+                                 + static_cast<double>(sample.z) * sample.z);
+    double elapsed = sample.timestamp - _lastAccelerometerTimestamp;
+    double alpha = _lastAccelerometerTimestamp > 0.0 && elapsed < kAccelerationTimeConstant * 20.0
+                   ? 1.0 - std::exp(-std::max(0.0, elapsed) / kAccelerationTimeConstant)
+                   : 1.0;
+    _lastAccelerometerTimestamp = sample.timestamp;
+    _state.timestamp = std::max(_state.timestamp, sample.timestamp);
+    _filteredMagnitude += alpha * (magnitude - _filteredMagnitude);
+
+    if (!_aboveThreshold && _filteredMagnitude > kStepThreshold)
+    {
+        _aboveThreshold = true;
+        if (_lastStepTimestamp < 0.0 || sample.timestamp - _lastStepTimestamp >= kMinimumStepInterval)
+        {
+            _lastStepTimestamp = sample.timestamp;
+            _state.stepCount++;
+            _stepTimestamps[_stepTimestampCount++ % _stepTimestamps.size()] = sample.timestamp;
+        }
+    }
+    else if (_aboveThreshold && _filteredMagnitude < kStepResetThreshold)
+    {
+        _aboveThreshold = false;
+    }
+
+    size_t recentSteps = 0;
+    double oldest = sample.timestamp;
+    size_t stored = std::min(_stepTimestampCount, _stepTimestamps.size());
+    for (size_t i = 0; i < stored; i++)
+    {
+        double timestamp = _stepTimestamps[i];
+        if (sample.timestamp - timestamp <= kStepFrequencyWindow)
+        {
+            recentSteps++;
+            oldest = std::min(oldest, timestamp);
+        }
+    }
+    double span = _lastStepTimestamp - oldest;
+    _state.stepFrequency = recentSteps >= 2 && span > 0.0 ? (recentSteps - 1) / span : 0.0;
+    _state.isMoving = _state.stepFrequency > 0.0 && sample.timestamp - _lastStepTimestamp <= kStandingTimeout;
+    _state.speed = _state.isMoving ? _state.stepFrequency * _stepLength : 0.0;
+}
+
+} // namespace eil
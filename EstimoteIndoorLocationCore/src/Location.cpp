@@ -0,0 +1,270 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/Location.hpp"
+
+#include "EILCore/NavigationGraph.hpp"
+#include "EILCore/PinIndex.hpp"
+#include "EILCore/SegmentIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace eil {
+
+namespace {
+
+/** Maximum number of rejected candidates before `randomPointInside` gives up. */
+constexpr int kMaxRandomPointAttempts = 10000;
+
+/** Number of values of `LinearObjectType`. */
+constexpr size_t kLinearObjectTypeCount = 2;
+static_assert(static_cast<size_t>(LinearObjectType::Window) + 1 == kLinearObjectTypeCount,
+              "kLinearObjectTypeCount must cover every LinearObjectType");
+
+double signedArea(const std::vector<Point> &polygon)
+{
+    double sum = 0.0;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+    {
+        sum += polygon[j].x * polygon[i].y - polygon[i].x * polygon[j].y;
+    }
+    return sum / 2.0;
+}
+
+} // namespace
+
+struct Location::DerivedGeometry
+{
+    std::once_flag shapeOnce;
+    std::vector<Point> polygon;
+    Rect boundingBox;
+    double area = 0.0;
+
+    std::once_flag linearObjectsOnce;
+    std::vector<LinearObject> linearObjectsByType[kLinearObjectTypeCount];
+
+    std::once_flag polygonIndexOnce;
+    std::unique_ptr<PolygonIndex> polygonIndex;
+    std::once_flag polygonSamplerOnce;
+    std::unique_ptr<PolygonSampler> polygonSampler;
+    std::once_flag segmentIndexOnce;
+    std::unique_ptr<SegmentIndex> segmentIndex;
+    std::once_flag pinIndexOnce;
+    std::unique_ptr<PinIndex> pinIndex;
+    std::once_flag navigationGraphOnce;
+    std::unique_ptr<NavigationGraph> navigationGraph;
+};
+
+Location::Location(std::string identifier,
+                   std::string name,
+                   std::vector<OrientedLineSegment> boundarySegments,
+                   std::vector<PositionedBeacon> beacons,
+                   std::vector<LinearObject> linearObjects,
+                   std::vector<LocationPin> locationPins,
+                   double orientation)
+    : _identifier(std::move(identifier)),
+      _name(std::move(name)),
+      _boundarySegments(std::move(boundarySegments)),
+      _beacons(std::move(beacons)),
+      _linearObjects(std::move(linearObjects)),
+      _locationPins(std::move(locationPins)),
+      _orientation(orientation),
+      _derivedGeometry(std::make_shared<DerivedGeometry>())
+{
+    for (size_t i = 0; i < _beacons.size(); i++)
+    {
+        _beaconIndices.emplace(_beacons[i].beacon, static_cast<int>(i));
+    }
+}
+
+const Location::DerivedGeometry &Location::shape() const
+{
+    DerivedGeometry &derived = *_derivedGeometry;
+    std::call_once(derived.shapeOnce, [this, &derived] {
+        std::vector<Point> &polygon = derived.polygon;
+        polygon.reserve(_boundarySegments.size());
+        for (const OrientedLineSegment &segment : _boundarySegments)
+        {
+            polygon.push_back(segment.point1);
+        }
+        if (polygon.size() >= 3)
+        {
+            double area = signedArea(polygon);
+            // Counter clockwise polygons have positive signed area in the Cartesian coordinate system.
+            if (area > 0.0)
+            {
+                std::reverse(polygon.begin(), polygon.end());
+            }
+            derived.area = std::fabs(area);
+        }
+
+        if (!polygon.empty())
+        {
+            Rect &box = derived.boundingBox;
+            box.minX = box.maxX = polygon[0].x;
+            box.minY = box.maxY = polygon[0].y;
+            for (const Point &point : polygon)
+            {
+                box.minX = std::min(box.minX, point.x);
+                box.minY = std::min(box.minY, point.y);
+                box.maxX = std::max(box.maxX, point.x);
+                box.maxY = std::max(box.maxY, point.y);
+            }
+        }
+    });
+    return derived;
+}
+
+const std::vector<Point> &Location::polygon() const
+{
+    return shape().polygon;
+}
+
+double Location::area() const
+{
+    return shape().area;
+}
+
+const Rect &Location::boundingBox() const
+{
+    return shape().boundingBox;
+}
+
+int Location::indexOfBeacon(BeaconId beacon) const
+{
+    auto it = _beaconIndices.find(beacon);
+    return it == _beaconIndices.end() ? -1 : it->second;
+}
+
+const PolygonIndex &Location::polygonIndex() const
+{
+    DerivedGeometry &derived = *_derivedGeometry;
+    std::call_once(derived.polygonIndexOnce,
+                   [this, &derived] { derived.polygonIndex.reset(new PolygonIndex(polygon())); });
+    return *derived.polygonIndex;
+}
+
+const PolygonSampler &Location::polygonSampler() const
+{
+    DerivedGeometry &derived = *_derivedGeometry;
+    std::call_once(derived.polygonSamplerOnce,
+                   [this, &derived] { derived.polygonSampler.reset(new PolygonSampler(polygon())); });
+    return *derived.polygonSampler;
+}
+
+const SegmentIndex &Location::segmentIndex() const
+{
+    DerivedGeometry &derived = *_derivedGeometry;
+    std::call_once(derived.segmentIndexOnce, [this, &derived] { derived.segmentIndex.reset(new SegmentIndex(*this)); });
+    return *derived.segmentIndex;
+}
+
+const PinIndex &Location::pinIndex() const
+{
+    DerivedGeometry &derived = *_derivedGeometry;
+    std::call_once(derived.pinIndexOnce, [this, &derived] { derived.pinIndex.reset(new PinIndex(*this)); });
+    return *derived.pinIndex;
+}
+
+const NavigationGraph &Location::navigationGraph() const
+{
+    DerivedGeometry &derived = *_derivedGeometry;
+    std::call_once(derived.navigationGraphOnce,
+                   [this, &derived] { derived.navigationGraph.reset(new NavigationGraph(*this)); });
+    return *derived.navigationGraph;
+}
+
+Point Location::randomPointInside(Random &random) const
+{
+    const PolygonSampler &sampler = polygonSampler();
+    if (sampler.isValid())
+    {
+        return sampler.sample(random);
+    }
+
+    // Self-intersecting boundaries cannot be triangulated; rejection sampling still works for them.
+    const PolygonIndex &index = polygonIndex();
+    const Rect &box = boundingBox();
+    for (int attempt = 0; attempt < kMaxRandomPointAttempts; attempt++)
+    {
+        double x = random.uniform(box.minX, box.maxX);
+        Point candidate(x, random.uniform(box.minY, box.maxY));
+        if (index.containsPoint(candidate.x, candidate.y))
+        {
+            return candidate;
+        }
+    }
+    return polygon().empty() ? Point() : polygon().front();
+}
+
+void Location::randomPointsInside(Random &random, Point *points, size_t count) const
+{
+    const PolygonSampler &sampler = polygonSampler();
+    if (sampler.isValid())
+    {
+        sampler.sample(random, points, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        points[i] = randomPointInside(random);
+    }
+}
+
+const std::vector<LinearObject> &Location::linearObjectsWithType(LinearObjectType type) const
+{
+    DerivedGeometry &derived = *_derivedGeometry;
+    std::call_once(derived.linearObjectsOnce, [this, &derived] {
+        for (const LinearObject &object : _linearObjects)
+        {
+            derived.linearObjectsByType[static_cast<size_t>(object.type)].push_back(object);
+        }
+    });
+    return derived.linearObjectsByType[static_cast<size_t>(type)];
+}
+
+Location Location::translatedBy(double dX, double dY) const
+{
+    return transformedBy(RigidTransform(dX, dY));
+}
+
+Location Location::transformedBy(const RigidTransform &transform) const
+{
+    std::vector<OrientedLineSegment> boundarySegments;
+    boundarySegments.reserve(_boundarySegments.size());
+    for (const OrientedLineSegment &segment : _boundarySegments)
+    {
+        boundarySegments.push_back(transform.apply(segment));
+    }
+
+    std::vector<PositionedBeacon> beacons = _beacons;
+    for (PositionedBeacon &beacon : beacons)
+    {
+        beacon.position = transform.apply(beacon.position);
+    }
+
+    std::vector<LinearObject> linearObjects = _linearObjects;
+    for (LinearObject &object : linearObjects)
+    {
+        object.position = transform.apply(object.position);
+    }
+
+    std::vector<LocationPin> locationPins = _locationPins;
+    for (LocationPin &pin : locationPins)
+    {
+        pin.position = transform.apply(pin.position);
+    }
+
+    // Content turning clockwise by some angle means magnetic north turned counter clockwise by the same angle.
+    double orientation = _orientation;
+    if (!transform.isTranslation())
+    {
+        orientation = std::fmod(_orientation - transform.angle(), 360.0);
+        orientation = orientation < 0.0 ? orientation + 360.0 : orientation;
+    }
+    return Location(_identifier, _name, std::move(boundarySegments), std::move(beacons),
+                    std::move(linearObjects), std::move(locationPins), orientation);
+}
+
+} // namespace eil
@@ -0,0 +1,151 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/LocationBuilder.hpp"
+
+namespace eil {
+
+const char *const kLocationDefaultName = "MyEstimoteLocation";
+
+namespace {
+
+/**
+ * Computes the end point of the segment that is on the given side when looking at the segment from inside of the location,
+ * together with the unit vector pointing from it towards the other end point.
+ */
+void sideOrigin(const OrientedLineSegment &segment, LocationBuilderSide side, Point &origin, Point &direction)
+{
+    Point inward = directionForOrientation(segment.orientation);
+    // Facing the wall means looking along -inward; the left hand then points along (inward.y, -inward.x).
+    Point left(inward.y, -inward.x);
+    double projection1 = segment.point1.x * left.x + segment.point1.y * left.y;
+    double projection2 = segment.point2.x * left.x + segment.point2.y * left.y;
+    bool point1IsLeft = projection1 >= projection2;
+    bool fromPoint1 = (side == LocationBuilderSide::Left) == point1IsLeft;
+
+    origin = fromPoint1 ? segment.point1 : segment.point2;
+    const Point &other = fromPoint1 ? segment.point2 : segment.point1;
+    double length = segment.length();
+    direction = length > 0.0 ? Point((other.x - origin.x) / length, (other.y - origin.y) / length) : Point();
+}
+
+} // namespace
+
+void LocationBuilder::setLocationBoundaryPoints(const std::vector<Point> &boundaryPoints)
+{
+    _boundaryPoints = boundaryPoints;
+}
+
+void LocationBuilder::addBeacon(const std::string &identifier, size_t boundarySegmentIndex, double distance, LocationBuilderSide side)
+{
+    _beacons.push_back({identifier, true, {boundarySegmentIndex, distance, 0.0, side}, OrientedPoint()});
+}
+
+void LocationBuilder::addBeacon(const std::string &identifier, const OrientedPoint &position)
+{
+    _beacons.push_back({identifier, false, {0, 0.0, 0.0, LocationBuilderSide::Left}, position});
+}
+
+void LocationBuilder::addLocationPin(const std::string &name, const std::string &type, const OrientedPoint &position)
+{
+    LocationPin pin;
+    pin.name = name;
+    pin.type = type;
+    pin.position = position;
+    _locationPins.push_back(pin);
+}
+
+void LocationBuilder::addDoor(double length, size_t boundarySegmentIndex, double distance, LocationBuilderSide side)
+{
+    _linearObjects.push_back({LinearObjectType::Door, {boundarySegmentIndex, distance, length, side}});
+}
+
+void LocationBuilder::addWindow(double length, size_t boundarySegmentIndex, double distance, LocationBuilderSide side)
+{
+    _linearObjects.push_back({LinearObjectType::Window, {boundarySegmentIndex, distance, length, side}});
+}
+
+LocationRef LocationBuilder::build() const
+{
+    size_t count = _boundaryPoints.size();
+    if (count < 3)
+    {
+        return nullptr;
+    }
+
+    double doubleSignedArea = 0.0;
+    for (size_t i = 0, j = count - 1; i < count; j = i++)
+    {
+        doubleSignedArea += _boundaryPoints[j].x * _boundaryPoints[i].y - _boundaryPoints[i].x * _boundaryPoints[j].y;
+    }
+    if (doubleSignedArea == 0.0)
+    {
+        return nullptr;
+    }
+    bool counterClockwise = doubleSignedArea > 0.0;
+
+    std::vector<OrientedLineSegment> boundarySegments;
+    boundarySegments.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Point &point1 = _boundaryPoints[i];
+        const Point &point2 = _boundaryPoints[(i + 1) % count];
+        double dX = point2.x - point1.x;
+        double dY = point2.y - point1.y;
+        // The interior is on the left of counter clockwise edges and on the right of clockwise ones.
+        double orientation = counterClockwise ? orientationForDirection(-dY, dX) : orientationForDirection(dY, -dX);
+        boundarySegments.emplace_back(point1, point2, orientation);
+    }
+
+    std::vector<PositionedBeacon> beacons;
+    beacons.reserve(_beacons.size());
+    for (const PlacedBeacon &placed : _beacons)
+    {
+        if (!placed.onBoundary)
+        {
+            beacons.emplace_back(placed.identifier, placed.position);
+            continue;
+        }
+        if (placed.placement.boundarySegmentIndex >= count)
+        {
+            return nullptr;
+        }
+        const OrientedLineSegment &segment = boundarySegments[placed.placement.boundarySegmentIndex];
+        Point origin, direction;
+        sideOrigin(segment, placed.placement.side, origin, direction);
+        OrientedPoint position(origin.x + direction.x * placed.placement.distance,
+                               origin.y + direction.y * placed.placement.distance,
+                               segment.orientation);
+        beacons.emplace_back(placed.identifier, position);
+    }
+
+    std::vector<LinearObject> linearObjects;
+    linearObjects.reserve(_linearObjects.size());
+    for (const PlacedLinearObject &placed : _linearObjects)
+    {
+        if (placed.placement.boundarySegmentIndex >= count)
+        {
+            return nullptr;
+        }
+        const OrientedLineSegment &segment = boundarySegments[placed.placement.boundarySegmentIndex];
+        Point origin, direction;
+        sideOrigin(segment, placed.placement.side, origin, direction);
+        double start = placed.placement.distance;
+        double end = placed.placement.distance + placed.placement.length;
+        LinearObject object;
+        object.type = placed.type;
+        object.position = OrientedLineSegment(Point(origin.x + direction.x * start, origin.y + direction.y * start),
+                                              Point(origin.x + direction.x * end, origin.y + direction.y * end),
+                                              segment.orientation);
+        linearObjects.push_back(object);
+    }
+
+    return std::make_shared<const Location>(_identifier,
+                                            _name.empty() ? std::string(kLocationDefaultName) : _name,
+                                            std::move(boundarySegments),
+                                            std::move(beacons),
+                                            std::move(linearObjects),
+                                            _locationPins,
+                                            _orientation);
+}
+
+} // namespace eil
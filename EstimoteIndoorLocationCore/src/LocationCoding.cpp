@@ -0,0 +1,189 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/LocationCoding.hpp"
+
+#include "BinaryCoding.hpp"
+
+namespace eil {
+
+namespace {
+
+constexpr uint8_t kLocationCodingVersion = 1;
+
+void putOrientedPoint(ByteWriter &writer, const OrientedPoint &point)
+{
+    writer.putDouble(point.x);
+    writer.putDouble(point.y);
+    writer.putDouble(point.orientation);
+}
+
+OrientedPoint getOrientedPoint(ByteReader &reader)
+{
+    double x = reader.getDouble();
+    double y = reader.getDouble();
+    return OrientedPoint(x, y, reader.getDouble());
+}
+
+void putSegment(ByteWriter &writer, const OrientedLineSegment &segment)
+{
+    writer.putDouble(segment.point1.x);
+    writer.putDouble(segment.point1.y);
+    writer.putDouble(segment.point2.x);
+    writer.putDouble(segment.point2.y);
+    writer.putDouble(segment.orientation);
+}
+
+OrientedLineSegment getSegment(ByteReader &reader)
+{
+    double x1 = reader.getDouble();
+    double y1 = reader.getDouble();
+    double x2 = reader.getDouble();
+    double y2 = reader.getDouble();
+    return OrientedLineSegment(Point(x1, y1), Point(x2, y2), reader.getDouble());
+}
+
+/** Guards against absurd element counts in corrupted data before anything gets allocated. */
+bool plausibleCount(const ByteReader &reader, uint64_t count, size_t minimumElementSize)
+{
+    return !reader.failed() && count <= reader.remaining() / minimumElementSize;
+}
+
+} // namespace
+
+std::string encodeLocation(const Location &location)
+{
+    std::string data;
+    ByteWriter writer(data);
+    writer.putUInt8(kLocationCodingVersion);
+    writer.putString(location.identifier());
+    writer.putString(location.name());
+    writer.putDouble(location.orientation());
+
+    writer.putVarUInt(location.boundarySegments().size());
+    for (const OrientedLineSegment &segment : location.boundarySegments())
+    {
+        putSegment(writer, segment);
+    }
+
+    writer.putVarUInt(location.beacons().size());
+    for (const PositionedBeacon &beacon : location.beacons())
+    {
+        writer.putString(beacon.identifier);
+        putOrientedPoint(writer, beacon.position);
+        writer.putString(beacon.proximityUUID);
+        writer.putVarInt(beacon.major);
+        writer.putVarInt(beacon.minor);
+    }
+
+    writer.putVarUInt(location.linearObjects().size());
+    for (const LinearObject &object : location.linearObjects())
+    {
+        writer.putUInt8(static_cast<uint8_t>(object.type));
+        putSegment(writer, object.position);
+    }
+
+    writer.putVarUInt(location.locationPins().size());
+    for (const LocationPin &pin : location.locationPins())
+    {
+        writer.putString(pin.name);
+        writer.putString(pin.type);
+        writer.putVarInt(pin.identifier);
+        putOrientedPoint(writer, pin.position);
+    }
+    return data;
+}
+
+LocationRef decodeLocation(const uint8_t *bytes, size_t length)
+{
+    ByteReader reader(bytes, length);
+    if (reader.getUInt8() != kLocationCodingVersion)
+    {
+        return nullptr;
+    }
+    std::string identifier = reader.getString();
+    std::string name = reader.getString();
+    double orientation = reader.getDouble();
+
+    uint64_t count = reader.getVarUInt();
+    if (!plausibleCount(reader, count, 40))
+    {
+        return nullptr;
+    }
+    std::vector<OrientedLineSegment> boundarySegments;
+    boundarySegments.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; i++)
+    {
+        boundarySegments.push_back(getSegment(reader));
+    }
+
+    count = reader.getVarUInt();
+    if (!plausibleCount(reader, count, 27))
+    {
+        return nullptr;
+    }
+    std::vector<PositionedBeacon> beacons;
+    beacons.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; i++)
+    {
+        std::string beaconIdentifier = reader.getString();
+        PositionedBeacon beacon(beaconIdentifier, getOrientedPoint(reader));
+        beacon.proximityUUID = reader.getString();
+        beacon.major = static_cast<int>(reader.getVarInt());
+        beacon.minor = static_cast<int>(reader.getVarInt());
+        beacons.push_back(beacon);
+    }
+
+    count = reader.getVarUInt();
+    if (!plausibleCount(reader, count, 41))
+    {
+        return nullptr;
+    }
+    std::vector<LinearObject> linearObjects;
+    linearObjects.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; i++)
+    {
+        LinearObject object;
+        object.type = reader.getUInt8() == static_cast<uint8_t>(LinearObjectType::Window) ? LinearObjectType::Window : LinearObjectType::Door;
+        object.position = getSegment(reader);
+        linearObjects.push_back(object);
+    }
+
+    count = reader.getVarUInt();
+    if (!plausibleCount(reader, count, 27))
+    {
+        return nullptr;
+    }
+    std::vector<LocationPin> locationPins;
+    locationPins.reserve(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; i++)
+    {
+        LocationPin pin;
+        pin.name = reader.getString();
+        pin.type = reader.getString();
+        pin.identifier = reader.getVarInt();
+        pin.position = getOrientedPoint(reader);
+        locationPins.push_back(pin);
+    }
+
+    if (reader.failed())
+    {
+        return nullptr;
+    }
+    return std::make_shared<const Location>(std::move(identifier), std::move(name), std::move(boundarySegments),
+                                            std::move(beacons), std::move(linearObjects), std::move(locationPins),
+                                            orientation);
+}
+
+uint64_t locationFingerprint(const Location &location)
+{
+    // 64-bit FNV-1a.
+    uint64_t hash = 14695981039346656037ULL;
+    for (char byte : encodeLocation(location))
+    {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace eil
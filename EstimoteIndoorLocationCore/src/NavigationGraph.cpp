@@ -0,0 +1,340 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/NavigationGraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+namespace eil {
+
+namespace {
+
+/** Nodes of very sharp reflex corners are moved at most this many clearances away from the corner. */
+constexpr double kMaximumClearanceStretch = 3.0;
+
+/** Entry of the priority queues of Dijkstra and A*, ordered by its key. */
+struct QueueEntry
+{
+    double key;
+    int node;
+
+    bool operator>(const QueueEntry &other) const { return key > other.key; }
+};
+
+typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> MinQueue;
+
+} // namespace
+
+constexpr double NavigationGraph::kDefaultClearance;
+constexpr size_t NavigationGraph::kMaximumCachedPinFields;
+
+NavigationGraph::NavigationGraph(const Location &location, double clearance)
+    : _walls(std::make_shared<const SegmentIndex>(location))
+{
+    // Polygon of the location is clockwise, so the inside is to the right of every edge and reflex corners turn left.
+    const std::vector<Point> &polygon = location.polygon();
+    std::vector<Point> nodes;
+    size_t count = polygon.size();
+    for (size_t i = 0; count >= 3 && i < count; i++)
+    {
+        const Point &previous = polygon[(i + count - 1) % count];
+        const Point &corner = polygon[i];
+        const Point &next = polygon[(i + 1) % count];
+        Point incoming(corner.x - previous.x, corner.y - previous.y);
+        Point outgoing(next.x - corner.x, next.y - corner.y);
+        double incomingLength = incoming.length();
+        double outgoingLength = outgoing.length();
+        if (incoming.x * outgoing.y - incoming.y * outgoing.x <= 0.0 || incomingLength == 0.0 || outgoingLength == 0.0)
+        {
+            continue;
+        }
+
+        // Moving along the mean of the inner normals by clearance / |mean|^2 keeps the node `clearance` from both walls.
+        Point mean((incoming.y / incomingLength + outgoing.y / outgoingLength) / 2.0,
+                   (-incoming.x / incomingLength - outgoing.x / outgoingLength) / 2.0);
+        double meanSquared = mean.x * mean.x + mean.y * mean.y;
+        double stretch = std::min(1.0 / meanSquared, kMaximumClearanceStretch / std::sqrt(meanSquared));
+        Point node(corner.x + mean.x * clearance * stretch, corner.y + mean.y * clearance * stretch);
+        // Corners of passages narrower than the clearance cannot be walked around.
+        if (location.containsPoint(node) && _walls->distanceToNearest(node, kWallSegments) >= clearance * 0.5)
+        {
+            nodes.push_back(node);
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> neighbours(nodes.size());
+    for (uint32_t i = 0; i < nodes.size(); i++)
+    {
+        for (uint32_t j = i + 1; j < nodes.size(); j++)
+        {
+            if (isVisible(nodes[i], nodes[j]))
+            {
+                neighbours[i].push_back(j);
+                neighbours[j].push_back(i);
+            }
+        }
+    }
+    _edgeOffsets.reserve(nodes.size() + 1);
+    for (uint32_t i = 0; i < nodes.size(); i++)
+    {
+        _edgeOffsets.push_back(static_cast<uint32_t>(_edgeTargets.size()));
+        for (uint32_t j : neighbours[i])
+        {
+            _edgeTargets.push_back(j);
+            _edgeLengths.push_back(nodes[i].distanceTo(nodes[j]));
+        }
+    }
+    _edgeOffsets.push_back(static_cast<uint32_t>(_edgeTargets.size()));
+    _nodes = std::make_shared<const std::vector<Point>>(std::move(nodes));
+
+    for (const LocationPin &pin : location.locationPins())
+    {
+        _pins.push_back(pin.position);
+    }
+}
+
+bool NavigationGraph::findRoute(const Point &from, const Point &to, Route &route) const
+{
+    const std::vector<Point> &nodes = *_nodes;
+    route.waypoints.clear();
+    route.length = std::numeric_limits<double>::infinity();
+    if (isVisible(from, to))
+    {
+        route.waypoints.push_back(from);
+        route.waypoints.push_back(to);
+        route.length = from.distanceTo(to);
+        return true;
+    }
+
+    // The destination is a virtual node after the real ones, linked to every node that sees it.
+    int goal = static_cast<int>(nodes.size());
+    std::vector<double> goalLinks(nodes.size(), std::numeric_limits<double>::infinity());
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (isVisible(nodes[i], to))
+        {
+            goalLinks[i] = nodes[i].distanceTo(to);
+        }
+    }
+
+    std::vector<double> costs(nodes.size() + 1, std::numeric_limits<double>::infinity());
+    std::vector<int> previous(nodes.size() + 1, -1);
+    std::vector<bool> closed(nodes.size() + 1, false);
+    MinQueue open;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (isVisible(from, nodes[i]))
+        {
+            costs[i] = from.distanceTo(nodes[i]);
+            open.push(QueueEntry{costs[i] + nodes[i].distanceTo(to), static_cast<int>(i)});
+        }
+    }
+
+    while (!open.empty())
+    {
+        int node = open.top().node;
+        open.pop();
+        if (closed[node])
+        {
+            continue;
+        }
+        closed[node] = true;
+        if (node == goal)
+        {
+            break;
+        }
+
+        auto relax = [&](int target, double cost, double heuristic) {
+            if (cost < costs[target])
+            {
+                costs[target] = cost;
+                previous[target] = node;
+                open.push(QueueEntry{cost + heuristic, target});
+            }
+        };
+        relax(goal, costs[node] + goalLinks[node], 0.0);
+        for (uint32_t edge = _edgeOffsets[node]; edge < _edgeOffsets[node + 1]; edge++)
+        {
+            int target = static_cast<int>(_edgeTargets[edge]);
+            if (!closed[target])
+            {
+                relax(target, costs[node] + _edgeLengths[edge], nodes[target].distanceTo(to));
+            }
+        }
+    }
+
+    if (!closed[goal])
+    {
+        return false;
+    }
+    route.waypoints.push_back(to);
+    for (int node = previous[goal]; node >= 0; node = previous[node])
+    {
+        route.waypoints.push_back(nodes[node]);
+    }
+    route.waypoints.push_back(from);
+    std::reverse(route.waypoints.begin(), route.waypoints.end());
+    route.length = costs[goal];
+    return true;
+}
+
+std::shared_ptr<const DistanceField> NavigationGraph::distanceFieldTo(const Point &destination) const
+{
+    return std::shared_ptr<const DistanceField>(new DistanceField(*this, destination));
+}
+
+std::shared_ptr<const DistanceField> NavigationGraph::pinDistanceField(size_t pinIndex) const
+{
+    if (pinIndex >= _pins.size())
+    {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_pinFieldsMutex);
+        auto it = _pinFieldsByPin.find(pinIndex);
+        if (it != _pinFieldsByPin.end())
+        {
+            _pinFields.splice(_pinFields.begin(), _pinFields, it->second);
+            return it->second->second;
+        }
+    }
+
+    // Computed without the lock, so queries to other pins are not blocked. A concurrent computation of the same
+    // field is wasted, but harmless.
+    std::shared_ptr<const DistanceField> field = distanceFieldTo(_pins[pinIndex]);
+    std::lock_guard<std::mutex> lock(_pinFieldsMutex);
+    if (_pinFieldsByPin.find(pinIndex) == _pinFieldsByPin.end())
+    {
+        _pinFields.emplace_front(pinIndex, field);
+        _pinFieldsByPin[pinIndex] = _pinFields.begin();
+        if (_pinFields.size() > kMaximumCachedPinFields)
+        {
+            _pinFieldsByPin.erase(_pinFields.back().first);
+            _pinFields.pop_back();
+        }
+    }
+    return field;
+}
+
+bool NavigationGraph::routeToPin(const Point &from, size_t pinIndex, Route &route) const
+{
+    std::shared_ptr<const DistanceField> field = pinDistanceField(pinIndex);
+    if (!field)
+    {
+        route.waypoints.clear();
+        route.length = std::numeric_limits<double>::infinity();
+        return false;
+    }
+    return field->routeFrom(from, route);
+}
+
+double NavigationGraph::distanceToPin(const Point &from, size_t pinIndex) const
+{
+    std::shared_ptr<const DistanceField> field = pinDistanceField(pinIndex);
+    return field ? field->distanceFrom(from) : std::numeric_limits<double>::infinity();
+}
+
+DistanceField::DistanceField(const NavigationGraph &graph, const Point &destination)
+    : _walls(graph._walls),
+      _nodes(graph._nodes),
+      _destination(destination),
+      _distances(_nodes->size(), std::numeric_limits<double>::infinity()),
+      _nextNodes(_nodes->size(), -1)
+{
+    const std::vector<Point> &nodes = *_nodes;
+    MinQueue open;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (isVisible(nodes[i], destination))
+        {
+            _distances[i] = nodes[i].distanceTo(destination);
+            open.push(QueueEntry{_distances[i], static_cast<int>(i)});
+        }
+    }
+    while (!open.empty())
+    {
+        QueueEntry entry = open.top();
+        open.pop();
+        if (entry.key > _distances[entry.node])
+        {
+            continue;
+        }
+        for (uint32_t edge = graph._edgeOffsets[entry.node]; edge < graph._edgeOffsets[entry.node + 1]; edge++)
+        {
+            uint32_t target = graph._edgeTargets[edge];
+            double distance = entry.key + graph._edgeLengths[edge];
+            if (distance < _distances[target])
+            {
+                _distances[target] = distance;
+                _nextNodes[target] = entry.node;
+                open.push(QueueEntry{distance, static_cast<int>(target)});
+            }
+        }
+    }
+}
+
+int DistanceField::firstNode(const Point &from, double &length) const
+{
+    length = std::numeric_limits<double>::infinity();
+    if (isVisible(from, _destination))
+    {
+        length = from.distanceTo(_destination);
+        return -1;
+    }
+
+    // Walking to a node and on along the field is a lower bound that is exact if the node is in straight sight.
+    // Candidates are checked cheapest first, so the first one in sight is the answer. The buffer is kept per thread,
+    // so rerouting on every position update does not allocate.
+    static thread_local std::vector<QueueEntry> candidates;
+    candidates.clear();
+    for (size_t i = 0; i < _distances.size(); i++)
+    {
+        if (_distances[i] < std::numeric_limits<double>::infinity())
+        {
+            candidates.push_back(QueueEntry{from.distanceTo((*_nodes)[i]) + _distances[i], static_cast<int>(i)});
+        }
+    }
+    std::make_heap(candidates.begin(), candidates.end(), std::greater<QueueEntry>());
+    while (!candidates.empty())
+    {
+        std::pop_heap(candidates.begin(), candidates.end(), std::greater<QueueEntry>());
+        QueueEntry candidate = candidates.back();
+        candidates.pop_back();
+        if (isVisible(from, (*_nodes)[candidate.node]))
+        {
+            length = candidate.key;
+            return candidate.node;
+        }
+    }
+    return -2;
+}
+
+double DistanceField::distanceFrom(const Point &from) const
+{
+    double length;
+    firstNode(from, length);
+    return length;
+}
+
+bool DistanceField::routeFrom(const Point &from, Route &route) const
+{
+    route.waypoints.clear();
+    double length;
+    int node = firstNode(from, length);
+    route.length = length;
+    if (node < -1)
+    {
+        return false;
+    }
+    route.waypoints.push_back(from);
+    for (; node >= 0; node = _nextNodes[node])
+    {
+        route.waypoints.push_back((*_nodes)[node]);
+    }
+    route.waypoints.push_back(_destination);
+    return true;
+}
+
+} // namespace eil
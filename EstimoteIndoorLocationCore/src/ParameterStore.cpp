@@ -0,0 +1,616 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/ParameterStore.hpp"
+
+#include "BinaryCoding.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <locale>
+#include <mutex>
+#include <sstream>
+
+namespace eil {
+
+namespace {
+
+const char kCacheMagic[8] = {'E', 'I', 'L', 'P', 'A', 'R', 'A', 'M'};
+constexpr uint16_t kCacheVersion = 1;
+constexpr size_t kCacheHeaderLength = sizeof(kCacheMagic) + 4;
+
+/** Nesting of unknown values deeper than this is rejected rather than recursed into. */
+constexpr int kMaximumNestingDepth = 16;
+
+/**
+ * Measures the number at the start of a string, following the JSON grammar strictly: no leading plus or zeros, no
+ * hexadecimal, no infinities.
+ *
+ * @return Length of the number, zero if the string does not start with one.
+ */
+size_t jsonNumberLength(const char *text)
+{
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+    const char *c = text;
+    if (*c == '-')
+    {
+        c++;
+    }
+    if (*c == '0')
+    {
+        c++;
+    }
+    else if (isDigit(*c))
+    {
+        while (isDigit(*c))
+        {
+            c++;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+    if (*c == '.')
+    {
+        if (!isDigit(*++c))
+        {
+            return 0;
+        }
+        while (isDigit(*c))
+        {
+            c++;
+        }
+    }
+    if (*c == 'e' || *c == 'E')
+    {
+        c++;
+        if (*c == '+' || *c == '-')
+        {
+            c++;
+        }
+        if (!isDigit(*c))
+        {
+            return 0;
+        }
+        while (isDigit(*c))
+        {
+            c++;
+        }
+    }
+    return static_cast<size_t>(c - text);
+}
+
+/** Formats a number for JSON in the classic locale, with the fewest digits that read back to the same value. */
+std::string formatJsonNumber(double value)
+{
+    // strtod and printf follow the process locale, which may use a decimal comma; streams can be given the classic one.
+    std::ostringstream stream;
+    stream.imbue(std::locale::classic());
+    stream.precision(15);
+    stream << value;
+    std::istringstream check(stream.str());
+    check.imbue(std::locale::classic());
+    double readBack = 0.0;
+    if (!(check >> readBack) || readBack != value)
+    {
+        stream.str(std::string());
+        stream.precision(17);
+        stream << value;
+    }
+    return stream.str();
+}
+
+struct DoubleField
+{
+    const char *name;
+    double AlgorithmParameters::*field;
+    double minimum;
+    double maximum;
+};
+
+struct IntField
+{
+    const char *name;
+    int AlgorithmParameters::*field;
+    int minimum;
+    int maximum;
+};
+
+/** Fields read from fetched parameters, with the ranges that keep the filter working. */
+const DoubleField kDoubleFields[] = {
+    {"measuredPower", &AlgorithmParameters::measuredPower, -120.0, 0.0},
+    {"pathLossExponent", &AlgorithmParameters::pathLossExponent, 0.1, 10.0},
+    {"rssiNoise", &AlgorithmParameters::rssiNoise, 0.1, 50.0},
+    {"rssiTimeConstant", &AlgorithmParameters::rssiTimeConstant, 0.01, 60.0},
+    {"beaconTimeout", &AlgorithmParameters::beaconTimeout, 0.1, 600.0},
+    {"maxWalkingSpeed", &AlgorithmParameters::maxWalkingSpeed, 0.1, 10.0},
+    {"minimumMotionNoise", &AlgorithmParameters::minimumMotionNoise, 0.0, 10.0},
+    {"beaconSelectionRadius", &AlgorithmParameters::beaconSelectionRadius, 0.0, 1000.0},
+    {"signalMapCellSize", &AlgorithmParameters::signalMapCellSize, 0.05, 10.0},
+    {"updateInterval", &AlgorithmParameters::updateInterval, 0.05, 60.0},
+    {"warmUpDuration", &AlgorithmParameters::warmUpDuration, 0.0, 600.0},
+    {"minimumDisplacementForOrientation", &AlgorithmParameters::minimumDisplacementForOrientation, 0.0, 10.0},
+};
+
+const IntField kIntFields[] = {
+    {"particleCount", &AlgorithmParameters::particleCount, 1, 100000},
+    {"strongestBeaconCount", &AlgorithmParameters::strongestBeaconCount, 0, 1000},
+};
+
+/** Reader of the small subset of JSON parameters are written in. Fails on anything it does not understand. */
+class JsonReader
+{
+public:
+    explicit JsonReader(const std::string &json) : _json(json) {}
+
+    bool atEnd()
+    {
+        skipWhitespace();
+        return _offset == _json.size();
+    }
+
+    bool consume(char c)
+    {
+        skipWhitespace();
+        if (_offset < _json.size() && _json[_offset] == c)
+        {
+            _offset++;
+            return true;
+        }
+        return false;
+    }
+
+    char peek()
+    {
+        skipWhitespace();
+        return _offset < _json.size() ? _json[_offset] : '\0';
+    }
+
+    bool readString(std::string &value)
+    {
+        if (!consume('"'))
+        {
+            return false;
+        }
+        value.clear();
+        while (_offset < _json.size())
+        {
+            char c = _json[_offset++];
+            if (c == '"')
+            {
+                return true;
+            }
+            if (c == '\\')
+            {
+                if (_offset >= _json.size())
+                {
+                    return false;
+                }
+                char escaped = _json[_offset++];
+                if (escaped == 'u')
+                {
+                    // Keys and values of interest are ASCII; other characters only need to be skipped.
+                    if (_offset + 4 > _json.size())
+                    {
+                        return false;
+                    }
+                    _offset += 4;
+                    value.push_back('?');
+                    continue;
+                }
+                static const char kEscapes[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+                const char *found = std::strchr(kEscapes, escaped);
+                if (escaped == '\0' || found == nullptr || (found - kEscapes) % 2 != 0)
+                {
+                    return false;
+                }
+                value.push_back(found[1]);
+                continue;
+            }
+            value.push_back(c);
+        }
+        return false;
+    }
+
+    bool readNumber(double &value)
+    {
+        skipWhitespace();
+        size_t length = jsonNumberLength(_json.c_str() + _offset);
+        if (length == 0)
+        {
+            return false;
+        }
+        std::istringstream stream(_json.substr(_offset, length));
+        stream.imbue(std::locale::classic());
+        if (!(stream >> value) || !std::isfinite(value))
+        {
+            return false;
+        }
+        _offset += length;
+        return true;
+    }
+
+    bool readBool(bool &value)
+    {
+        skipWhitespace();
+        if (_json.compare(_offset, 4, "true") == 0)
+        {
+            _offset += 4;
+            value = true;
+            return true;
+        }
+        if (_json.compare(_offset, 5, "false") == 0)
+        {
+            _offset += 5;
+            value = false;
+            return true;
+        }
+        return false;
+    }
+
+    bool skipValue(int depth = 0)
+    {
+        if (depth > kMaximumNestingDepth)
+        {
+            return false;
+        }
+        char c = peek();
+        std::string string;
+        double number;
+        bool flag;
+        if (c == '"')
+        {
+            return readString(string);
+        }
+        if (c == 't' || c == 'f')
+        {
+            return readBool(flag);
+        }
+        if (c == 'n')
+        {
+            bool isNull = _json.compare(_offset, 4, "null") == 0;
+            _offset += isNull ? 4 : 0;
+            return isNull;
+        }
+        if (c == '[' || c == '{')
+        {
+            bool isObject = c == '{';
+            char closing = isObject ? '}' : ']';
+            consume(c);
+            if (consume(closing))
+            {
+                return true;
+            }
+            do
+            {
+                if ((isObject && (!readString(string) || !consume(':'))) || !skipValue(depth + 1))
+                {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(closing);
+        }
+        return readNumber(number);
+    }
+
+private:
+    void skipWhitespace()
+    {
+        while (_offset < _json.size() && _json[_offset] != '\0' && std::strchr(" \t\r\n", _json[_offset]) != nullptr)
+        {
+            _offset++;
+        }
+    }
+
+    const std::string &_json;
+    size_t _offset = 0;
+};
+
+bool readField(JsonReader &reader, const std::string &key, AlgorithmParameters &parameters, int64_t &revision)
+{
+    double number;
+    for (const DoubleField &field : kDoubleFields)
+    {
+        if (key == field.name)
+        {
+            if (!reader.readNumber(number) || number < field.minimum || number > field.maximum)
+            {
+                return false;
+            }
+            parameters.*field.field = number;
+            return true;
+        }
+    }
+    for (const IntField &field : kIntFields)
+    {
+        if (key == field.name)
+        {
+            if (!reader.readNumber(number) || number != std::floor(number) || number < field.minimum
+                || number > field.maximum)
+            {
+                return false;
+            }
+            parameters.*field.field = static_cast<int>(number);
+            return true;
+        }
+    }
+    if (key == "provideOrientation")
+    {
+        return reader.readBool(parameters.provideOrientation);
+    }
+    if (key == "revision")
+    {
+        if (!reader.readNumber(number) || number != std::floor(number) || std::fabs(number) > 9.0e15)
+        {
+            return false;
+        }
+        revision = static_cast<int64_t>(number);
+        return true;
+    }
+    return reader.skipValue();
+}
+
+bool readFile(const std::string &path, std::string &data)
+{
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    data.clear();
+    char chunk[16 * 1024];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.append(chunk, read);
+    }
+    std::fclose(file);
+    return true;
+}
+
+double wallClockTime()
+{
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+bool decodeAlgorithmParameters(const std::string &json, AlgorithmParameters &parameters, int64_t &revision)
+{
+    AlgorithmParameters result = parameters;
+    int64_t resultRevision = 0;
+    JsonReader reader(json);
+    if (!reader.consume('{'))
+    {
+        return false;
+    }
+    if (!reader.consume('}'))
+    {
+        std::string key;
+        do
+        {
+            if (!reader.readString(key) || !reader.consume(':') || !readField(reader, key, result, resultRevision))
+            {
+                return false;
+            }
+        } while (reader.consume(','));
+        if (!reader.consume('}'))
+        {
+            return false;
+        }
+    }
+    if (!reader.atEnd())
+    {
+        return false;
+    }
+    parameters = result;
+    revision = resultRevision;
+    return true;
+}
+
+std::string encodeAlgorithmParameters(const AlgorithmParameters &parameters, int64_t revision)
+{
+    std::string json = "{";
+    char value[64];
+    if (revision != 0)
+    {
+        std::snprintf(value, sizeof(value), "\"revision\":%lld,", static_cast<long long>(revision));
+        json += value;
+    }
+    for (const DoubleField &field : kDoubleFields)
+    {
+        json += '"';
+        json += field.name;
+        json += "\":";
+        json += formatJsonNumber(parameters.*field.field);
+        json += ',';
+    }
+    for (const IntField &field : kIntFields)
+    {
+        std::snprintf(value, sizeof(value), "\"%s\":%d,", field.name, parameters.*field.field);
+        json += value;
+    }
+    json += "\"provideOrientation\":";
+    json += parameters.provideOrientation ? "true}" : "false}";
+    return json;
+}
+
+struct ParameterStore::State
+{
+    std::mutex mutex;
+    std::string cachePath;
+    AlgorithmParameters parameters;
+    int64_t revision = 0;
+    ParameterSource source = ParameterSource::Defaults;
+    /** Validators of the cached response, sent along with the next request. */
+    std::string etag;
+    std::string lastModified;
+    bool isRefreshing = false;
+};
+
+ParameterStore::ParameterStore(std::string url, std::string cachePath, Transport transport)
+    : _url(std::move(url)),
+      _transport(std::move(transport)),
+      _state(std::make_shared<State>())
+{
+    _state->cachePath = std::move(cachePath);
+
+    std::string data;
+    if (!readFile(_state->cachePath, data) || data.size() < kCacheHeaderLength
+        || std::memcmp(data.data(), kCacheMagic, sizeof(kCacheMagic)) != 0)
+    {
+        return;
+    }
+    ByteReader reader(reinterpret_cast<const uint8_t *>(data.data()) + sizeof(kCacheMagic),
+                      data.size() - sizeof(kCacheMagic));
+    if (reader.getUInt16() != kCacheVersion)
+    {
+        return;
+    }
+    reader.getUInt16();
+    reader.getDouble();
+    std::string etag = reader.getString();
+    std::string lastModified = reader.getString();
+    std::string body = reader.getString();
+    AlgorithmParameters parameters;
+    int64_t revision = 0;
+    if (reader.failed() || !decodeAlgorithmParameters(body, parameters, revision))
+    {
+        return;
+    }
+    _state->parameters = parameters;
+    _state->revision = revision;
+    _state->source = ParameterSource::Cache;
+    _state->etag = std::move(etag);
+    _state->lastModified = std::move(lastModified);
+}
+
+bool ParameterStore::loadBundle(const std::string &path)
+{
+    std::string json;
+    AlgorithmParameters parameters;
+    int64_t revision = 0;
+    if (!readFile(path, json) || !decodeAlgorithmParameters(json, parameters, revision))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    // An app update may ship a bundle newer than what was fetched by the previous version of the app.
+    if (_state->source == ParameterSource::Defaults || revision > _state->revision)
+    {
+        _state->parameters = parameters;
+        _state->revision = revision;
+        _state->source = ParameterSource::Bundle;
+    }
+    return true;
+}
+
+AlgorithmParameters ParameterStore::parameters() const
+{
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->parameters;
+}
+
+int64_t ParameterStore::revision() const
+{
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->revision;
+}
+
+ParameterSource ParameterStore::source() const
+{
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->source;
+}
+
+void ParameterStore::refresh(std::function<void(bool changed)> completion)
+{
+    ParameterRequest request;
+    bool isStarted = false;
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        if (!_state->isRefreshing && _transport)
+        {
+            _state->isRefreshing = true;
+            isStarted = true;
+            request.url = _url;
+            request.ifNoneMatch = _state->etag;
+            request.ifModifiedSince = _state->lastModified;
+        }
+    }
+    if (!isStarted)
+    {
+        if (completion)
+        {
+            completion(false);
+        }
+        return;
+    }
+
+    // The lock is not held while the transport runs; it may complete synchronously.
+    std::shared_ptr<State> state = _state;
+    _transport(request, [state, completion](const ParameterResponse &response) {
+        handleResponse(state, response, completion);
+    });
+}
+
+void ParameterStore::handleResponse(const std::shared_ptr<State> &state, const ParameterResponse &response,
+                                    const std::function<void(bool changed)> &completion)
+{
+    AlgorithmParameters parameters;
+    int64_t revision = 0;
+    bool isValid = response.statusCode == 200 && decodeAlgorithmParameters(response.body, parameters, revision);
+
+    bool changed = false;
+    std::string cachePath;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->isRefreshing = false;
+        if (isValid)
+        {
+            changed = revision != state->revision
+                      || encodeAlgorithmParameters(parameters) != encodeAlgorithmParameters(state->parameters);
+            state->parameters = parameters;
+            state->revision = revision;
+            state->source = ParameterSource::Network;
+            state->etag = response.etag;
+            state->lastModified = response.lastModified;
+            cachePath = state->cachePath;
+        }
+    }
+
+    if (isValid && !cachePath.empty())
+    {
+        std::string buffer(kCacheMagic, sizeof(kCacheMagic));
+        ByteWriter writer(buffer);
+        writer.putUInt16(kCacheVersion);
+        writer.putUInt16(0);
+        writer.putDouble(wallClockTime());
+        writer.putString(response.etag);
+        writer.putString(response.lastModified);
+        writer.putString(response.body);
+
+        // Written next to the target and renamed over it, so a crash never leaves a truncated cache behind.
+        std::string temporaryPath = cachePath + ".tmp";
+        FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+        if (file != nullptr)
+        {
+            bool written = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+            written = std::fclose(file) == 0 && written;
+            if (!written || std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+            {
+                std::remove(temporaryPath.c_str());
+            }
+        }
+    }
+
+    if (completion)
+    {
+        completion(changed);
+    }
+}
+
+} // namespace eil
@@ -0,0 +1,339 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/ParticleFilter.hpp"
+
+#include "EILCore/InertialFusion.hpp"
+#include "EILCore/LocationCoding.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace eil {
+
+namespace {
+
+/** Distances below this value are clamped, the path loss model does not hold in the near field. */
+constexpr double kMinimumDistanceSquared = 0.25;
+
+/** Factor applied to the walking speed measured by inertial sensors. */
+constexpr double kMotionSpeedMargin = 1.5;
+
+} // namespace
+
+ParticleFilter::ParticleFilter(LocationRef location, const AlgorithmParameters &parameters)
+    : _location(std::move(location)),
+      _parameters(parameters)
+{
+    seedRandom();
+}
+
+void ParticleFilter::setSignalMap(SignalMapRef map)
+{
+    // A map for different beacons would be indexed out of bounds; the full check is up to the caller, it is too costly here.
+    _signalMap = map && map->beaconCount() == _location->beacons().size() ? std::move(map) : nullptr;
+}
+
+void ParticleFilter::reset()
+{
+    _initialized = false;
+    // A seeded filter starts over from the same stream, so a run after a reset replays like a fresh one.
+    seedRandom();
+}
+
+void ParticleFilter::seedRandom()
+{
+    if (_parameters.randomSeed != 0)
+    {
+        // Derived from the content rather than the start order, so a location gets the same stream however it was started.
+        _random.seed(Random::mixSeed(_parameters.randomSeed, locationFingerprint(*_location)));
+    }
+}
+
+void ParticleFilter::initialize()
+{
+    size_t count = static_cast<size_t>(std::max(1, _parameters.particleCount));
+    _xs.resize(count);
+    _ys.resize(count);
+    _weights.assign(count, 1.0 / count);
+    std::vector<Point> points(count);
+    _location->randomPointsInside(_random, points.data(), count);
+    for (size_t i = 0; i < count; i++)
+    {
+        _xs[i] = points[i].x;
+        _ys[i] = points[i].y;
+    }
+    _initialized = true;
+}
+
+int ParticleFilter::step(double timestamp, const BeaconFilterBank &beacons, const MotionState *motion)
+{
+    selectBeacons(timestamp, beacons);
+    // Without measurements the estimate is left untouched; the motion model catches up with the elapsed time on the next step.
+    if (_beaconIndices.empty())
+    {
+        return 0;
+    }
+
+    double elapsed = 0.0;
+    if (!_initialized)
+    {
+        initialize();
+    }
+    else
+    {
+        elapsed = std::max(0.0, timestamp - _lastTimestamp);
+    }
+    _lastTimestamp = timestamp;
+
+    predict(elapsed, motion);
+    correct(_beaconIndices, _rssis);
+    resampleIfNeeded();
+    return static_cast<int>(_beaconIndices.size());
+}
+
+void ParticleFilter::selectBeacons(double timestamp, const BeaconFilterBank &beacons)
+{
+    // Candidates are gathered from the beacons actually heard rather than from all beacons of the location,
+    // so the cost stays bounded by the radio range instead of growing with the venue.
+    _candidates.clear();
+    for (const auto &entry : beacons.states())
+    {
+        if (timestamp - entry.second.lastSeen > _parameters.beaconTimeout)
+        {
+            continue;
+        }
+        int index = _location->indexOfBeacon(entry.first);
+        if (index >= 0)
+        {
+            _candidates.emplace_back(entry.second.rssi, index);
+        }
+    }
+
+    size_t strongestCount = std::min(_candidates.size(), static_cast<size_t>(std::max(0, _parameters.strongestBeaconCount)));
+    bool selectByDistance = _initialized && _parameters.beaconSelectionRadius > 0.0 && _candidates.size() > strongestCount;
+    if (selectByDistance)
+    {
+        // Strongest first; ties are broken by index to keep the selection independent of the hash map order.
+        std::partial_sort(_candidates.begin(), _candidates.begin() + strongestCount, _candidates.end(),
+                          [](const std::pair<double, int> &a, const std::pair<double, int> &b) {
+                              return a.first > b.first || (a.first == b.first && a.second < b.second);
+                          });
+
+        // The radius grows with the uncertainty of the estimate, so a spread cloud still sees the beacons around it.
+        PositionUpdate current = estimate();
+        double radius = _parameters.beaconSelectionRadius + current.accuracyRadius;
+        const std::vector<PositionedBeacon> &locationBeacons = _location->beacons();
+        auto end = std::remove_if(_candidates.begin() + strongestCount, _candidates.end(),
+                                  [&](const std::pair<double, int> &candidate) {
+                                      const OrientedPoint &position = locationBeacons[candidate.second].position;
+                                      double dX = position.x - current.position.x;
+                                      double dY = position.y - current.position.y;
+                                      return dX * dX + dY * dY > radius * radius;
+                                  });
+        _candidates.erase(end, _candidates.end());
+    }
+    std::sort(_candidates.begin(), _candidates.end(), [](const std::pair<double, int> &a, const std::pair<double, int> &b) {
+        return a.second < b.second;
+    });
+
+    _beaconIndices.clear();
+    _rssis.clear();
+    for (const std::pair<double, int> &candidate : _candidates)
+    {
+        _beaconIndices.push_back(candidate.second);
+        _rssis.push_back(candidate.first);
+    }
+}
+
+void ParticleFilter::predict(double elapsed, const MotionState *motion)
+{
+    double speed = _parameters.maxWalkingSpeed;
+    if (motion != nullptr)
+    {
+        // Step detection bounds the walk: a standing user keeps the cloud tight, a walking one spreads it by the measured
+        // pace with some margin for the step length being off.
+        speed = motion->isMoving ? std::min(_parameters.maxWalkingSpeed, motion->speed * kMotionSpeedMargin) : 0.0;
+    }
+    double sigma = std::max(_parameters.minimumMotionNoise, speed * elapsed / 2.0);
+    const PolygonIndex &boundary = _location->polygonIndex();
+    for (size_t i = 0; i < _xs.size(); i++)
+    {
+        double x = _xs[i] + _random.normal(0.0, sigma);
+        double y = _ys[i] + _random.normal(0.0, sigma);
+        // Particles cannot walk through the boundary of the location, they stay in place instead.
+        if (boundary.containsPoint(x, y))
+        {
+            _xs[i] = x;
+            _ys[i] = y;
+        }
+    }
+}
+
+void ParticleFilter::correct(const std::vector<int> &beaconIndices, const std::vector<double> &rssis)
+{
+    const std::vector<PositionedBeacon> &locationBeacons = _location->beacons();
+    double inverseVariance = 1.0 / (2.0 * _parameters.rssiNoise * _parameters.rssiNoise);
+    // 10 * n * log10(d) == 5 * n * log10(d²), which spares the square root.
+    double pathLossFactor = 5.0 * _parameters.pathLossExponent;
+
+    _logWeights.resize(_xs.size());
+    double maxLogWeight = -std::numeric_limits<double>::infinity();
+    const SignalMap *map = _signalMap.get();
+    for (size_t i = 0; i < _xs.size(); i++)
+    {
+        double logWeight = std::log(_weights[i]);
+        if (map != nullptr)
+        {
+            size_t cell = map->cellIndex(_xs[i], _ys[i]);
+            for (size_t b = 0; b < beaconIndices.size(); b++)
+            {
+                double error = rssis[b] - map->expectedRssi(cell, beaconIndices[b]);
+                logWeight -= error * error * inverseVariance;
+            }
+        }
+        else
+        {
+            for (size_t b = 0; b < beaconIndices.size(); b++)
+            {
+                const OrientedPoint &beacon = locationBeacons[beaconIndices[b]].position;
+                double dX = _xs[i] - beacon.x;
+                double dY = _ys[i] - beacon.y;
+                double distanceSquared = std::max(kMinimumDistanceSquared, dX * dX + dY * dY);
+                double expected = _parameters.measuredPower - pathLossFactor * std::log10(distanceSquared);
+                double error = rssis[b] - expected;
+                logWeight -= error * error * inverseVariance;
+            }
+        }
+        _logWeights[i] = logWeight;
+        maxLogWeight = std::max(maxLogWeight, logWeight);
+    }
+
+    double sum = 0.0;
+    for (size_t i = 0; i < _xs.size(); i++)
+    {
+        _weights[i] = std::exp(_logWeights[i] - maxLogWeight);
+        sum += _weights[i];
+    }
+    for (double &weight : _weights)
+    {
+        weight /= sum;
+    }
+}
+
+void ParticleFilter::resampleIfNeeded()
+{
+    double sumOfSquares = 0.0;
+    for (double weight : _weights)
+    {
+        sumOfSquares += weight * weight;
+    }
+    size_t count = _xs.size();
+    if (1.0 / sumOfSquares >= count / 2.0)
+    {
+        return;
+    }
+
+    // Systematic resampling.
+    _resampledXs.resize(count);
+    _resampledYs.resize(count);
+    double step = 1.0 / count;
+    double position = _random.uniform(0.0, step);
+    double cumulative = _weights[0];
+    size_t source = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        while (position > cumulative && source + 1 < count)
+        {
+            cumulative += _weights[++source];
+        }
+        _resampledXs[i] = _xs[source];
+        _resampledYs[i] = _ys[source];
+        position += step;
+    }
+    _xs.swap(_resampledXs);
+    _ys.swap(_resampledYs);
+    std::fill(_weights.begin(), _weights.end(), step);
+}
+
+std::vector<Particle> ParticleFilter::particles() const
+{
+    std::vector<Particle> particles;
+    if (!_initialized)
+    {
+        return particles;
+    }
+    particles.resize(_xs.size());
+    for (size_t i = 0; i < _xs.size(); i++)
+    {
+        particles[i].x = _xs[i];
+        particles[i].y = _ys[i];
+        particles[i].weight = _weights[i];
+    }
+    return particles;
+}
+
+bool ParticleFilter::restoreParticles(const std::vector<Particle> &particles, double timestamp)
+{
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> weights;
+    double sum = 0.0;
+    for (const Particle &particle : particles)
+    {
+        if (particle.weight > 0.0 && std::isfinite(particle.weight) && _location->containsPoint(particle.x, particle.y))
+        {
+            xs.push_back(particle.x);
+            ys.push_back(particle.y);
+            weights.push_back(particle.weight);
+            sum += particle.weight;
+        }
+    }
+    if (xs.empty())
+    {
+        return false;
+    }
+    for (double &weight : weights)
+    {
+        weight /= sum;
+    }
+
+    _xs.swap(xs);
+    _ys.swap(ys);
+    _weights.swap(weights);
+    _lastTimestamp = timestamp;
+    _initialized = true;
+    return true;
+}
+
+PositionUpdate ParticleFilter::estimate() const
+{
+    PositionUpdate update;
+    update.timestamp = _lastTimestamp;
+    if (!_initialized)
+    {
+        return update;
+    }
+
+    double meanX = 0.0;
+    double meanY = 0.0;
+    for (size_t i = 0; i < _xs.size(); i++)
+    {
+        meanX += _weights[i] * _xs[i];
+        meanY += _weights[i] * _ys[i];
+    }
+    double spread = 0.0;
+    for (size_t i = 0; i < _xs.size(); i++)
+    {
+        double dX = _xs[i] - meanX;
+        double dY = _ys[i] - meanY;
+        spread += _weights[i] * (dX * dX + dY * dY);
+    }
+
+    update.position = OrientedPoint(meanX, meanY);
+    update.accuracyRadius = std::sqrt(spread);
+    update.accuracy = accuracyForRadius(update.accuracyRadius);
+    return update;
+}
+
+} // namespace eil
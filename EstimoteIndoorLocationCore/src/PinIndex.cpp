@@ -0,0 +1,221 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PinIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace eil {
+
+namespace {
+
+/** Matches pins of every type. */
+constexpr uint32_t kAnyType = UINT32_MAX;
+
+/** Types beyond the 63rd share the last bit, which only makes pruning less effective. */
+uint64_t bitOfType(uint32_t typeId)
+{
+    return uint64_t(1) << std::min<uint32_t>(typeId, 63);
+}
+
+/** Orders hits by distance, then by index. */
+bool isCloser(const PinHit &a, const PinHit &b)
+{
+    return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+}
+
+} // namespace
+
+struct PinIndex::Search
+{
+    Point point;
+    uint32_t typeId = kAnyType;
+    uint64_t typeBits = ~uint64_t(0);
+    /** Maximum number of hits for nearest queries, zero for radius queries. */
+    size_t count = 0;
+    /** Squared radius for radius queries. */
+    double radiusSquared = 0.0;
+    /** Hits with squared distances. A max-heap by `isCloser` for nearest queries. */
+    std::vector<PinHit> *hits = nullptr;
+
+    /** Squared distance beyond which no pin can make it into the hits. */
+    double bound() const
+    {
+        if (count == 0)
+        {
+            return radiusSquared;
+        }
+        return hits->size() < count ? std::numeric_limits<double>::infinity() : hits->front().distance;
+    }
+
+    void offer(uint32_t index, double distanceSquared)
+    {
+        PinHit hit;
+        hit.index = index;
+        hit.distance = distanceSquared;
+        if (count == 0)
+        {
+            if (distanceSquared <= radiusSquared)
+            {
+                hits->push_back(hit);
+            }
+            return;
+        }
+        if (hits->size() < count)
+        {
+            hits->push_back(hit);
+            std::push_heap(hits->begin(), hits->end(), isCloser);
+        }
+        else if (isCloser(hit, hits->front()))
+        {
+            std::pop_heap(hits->begin(), hits->end(), isCloser);
+            hits->back() = hit;
+            std::push_heap(hits->begin(), hits->end(), isCloser);
+        }
+    }
+};
+
+PinIndex::PinIndex(const Location &location)
+{
+    const std::vector<LocationPin> &pins = location.locationPins();
+    _pins.reserve(pins.size());
+    for (size_t i = 0; i < pins.size(); i++)
+    {
+        auto inserted = _typeIds.emplace(pins[i].type, static_cast<uint32_t>(_typeIds.size()));
+        Node node;
+        node.position = pins[i].position;
+        node.index = static_cast<uint32_t>(i);
+        node.splitX = true;
+        node.typeId = inserted.first->second;
+        node.subtreeTypes = 0;
+        _pins.push_back(node);
+    }
+    build(0, static_cast<uint32_t>(_pins.size()));
+}
+
+uint64_t PinIndex::build(uint32_t begin, uint32_t end)
+{
+    if (begin >= end)
+    {
+        return 0;
+    }
+
+    double minX = _pins[begin].position.x, maxX = minX;
+    double minY = _pins[begin].position.y, maxY = minY;
+    for (uint32_t i = begin + 1; i < end; i++)
+    {
+        minX = std::min(minX, _pins[i].position.x);
+        maxX = std::max(maxX, _pins[i].position.x);
+        minY = std::min(minY, _pins[i].position.y);
+        maxY = std::max(maxY, _pins[i].position.y);
+    }
+    bool splitX = maxX - minX >= maxY - minY;
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(_pins.begin() + begin, _pins.begin() + middle, _pins.begin() + end,
+                     [splitX](const Node &a, const Node &b) {
+                         return splitX ? a.position.x < b.position.x : a.position.y < b.position.y;
+                     });
+
+    Node &node = _pins[middle];
+    node.splitX = splitX;
+    uint64_t types = bitOfType(node.typeId);
+    types |= build(begin, middle);
+    types |= build(middle + 1, end);
+    _pins[middle].subtreeTypes = types;
+    return types;
+}
+
+bool PinIndex::filterByType(Search &query, const std::string &type) const
+{
+    if (type.empty())
+    {
+        return true;
+    }
+    auto it = _typeIds.find(type);
+    if (it == _typeIds.end())
+    {
+        return false;
+    }
+    query.typeId = it->second;
+    query.typeBits = bitOfType(it->second);
+    return true;
+}
+
+void PinIndex::pinsNearestToPoint(const Point &point, size_t count, std::vector<PinHit> &hits,
+                                  const std::string &type) const
+{
+    hits.clear();
+    Search query;
+    query.point = point;
+    query.count = count;
+    query.hits = &hits;
+    if (count == 0 || !filterByType(query, type))
+    {
+        return;
+    }
+    search(query, 0, static_cast<uint32_t>(_pins.size()));
+
+    std::sort_heap(hits.begin(), hits.end(), isCloser);
+    for (PinHit &hit : hits)
+    {
+        hit.distance = std::sqrt(hit.distance);
+    }
+}
+
+void PinIndex::pinsWithinRadius(double radius, const Point &point, std::vector<PinHit> &hits,
+                                const std::string &type) const
+{
+    hits.clear();
+    Search query;
+    query.point = point;
+    query.radiusSquared = radius * radius;
+    query.hits = &hits;
+    if (!(radius >= 0.0) || !filterByType(query, type))
+    {
+        return;
+    }
+    search(query, 0, static_cast<uint32_t>(_pins.size()));
+
+    std::sort(hits.begin(), hits.end(), isCloser);
+    for (PinHit &hit : hits)
+    {
+        hit.distance = std::sqrt(hit.distance);
+    }
+}
+
+void PinIndex::search(Search &query, uint32_t begin, uint32_t end) const
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    uint32_t middle = begin + (end - begin) / 2;
+    const Node &node = _pins[middle];
+    if (!(node.subtreeTypes & query.typeBits))
+    {
+        return;
+    }
+
+    double dX = query.point.x - node.position.x;
+    double dY = query.point.y - node.position.y;
+    if (query.typeId == kAnyType || query.typeId == node.typeId)
+    {
+        double distanceSquared = dX * dX + dY * dY;
+        if (distanceSquared <= query.bound())
+        {
+            query.offer(node.index, distanceSquared);
+        }
+    }
+
+    // The side of the point first; the other side only if the splitting line is not farther than the bound.
+    double offset = node.splitX ? dX : dY;
+    bool nearIsLeft = offset < 0.0;
+    search(query, nearIsLeft ? begin : middle + 1, nearIsLeft ? middle : end);
+    if (offset * offset <= query.bound())
+    {
+        search(query, nearIsLeft ? middle + 1 : begin, nearIsLeft ? end : middle);
+    }
+}
+
+} // namespace eil
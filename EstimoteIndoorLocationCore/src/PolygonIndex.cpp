@@ -0,0 +1,166 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PolygonIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eil {
+
+namespace {
+
+/** Polygons with at most this many vertices are tested directly; a lookup would not be faster. */
+constexpr size_t kMaximumDirectVertexCount = 8;
+
+/** Grid cells per vertex of the polygon, and bounds of the grid size. */
+constexpr size_t kCellsPerVertex = 16;
+constexpr size_t kMinimumCellCount = 64;
+constexpr size_t kMaximumCellCount = 16384;
+
+/** Slack added around edges when marking boundary cells, in meters. Far above rounding errors, far below a cell. */
+constexpr double kBoundaryMargin = 1e-9;
+
+} // namespace
+
+constexpr uint8_t PolygonIndex::kOutsideCell;
+constexpr uint8_t PolygonIndex::kInsideCell;
+constexpr uint8_t PolygonIndex::kBoundaryCell;
+constexpr uint8_t PolygonIndex::kBoundaryCellCrossed;
+
+PolygonIndex::PolygonIndex(std::vector<Point> polygon)
+{
+    if (polygon.size() < 3)
+    {
+        // Nothing is inside; an empty box rejects every point.
+        _boundingBox.minX = _boundingBox.minY = 1.0;
+        _boundingBox.maxX = _boundingBox.maxY = 0.0;
+        return;
+    }
+
+    std::vector<Edge> edges;
+    edges.reserve(polygon.size());
+    _boundingBox.minX = _boundingBox.maxX = polygon[0].x;
+    _boundingBox.minY = _boundingBox.maxY = polygon[0].y;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+    {
+        edges.push_back(Edge{polygon[i], polygon[j]});
+        _boundingBox.minX = std::min(_boundingBox.minX, polygon[i].x);
+        _boundingBox.minY = std::min(_boundingBox.minY, polygon[i].y);
+        _boundingBox.maxX = std::max(_boundingBox.maxX, polygon[i].x);
+        _boundingBox.maxY = std::max(_boundingBox.maxY, polygon[i].y);
+    }
+
+    if (polygon.size() <= kMaximumDirectVertexCount || !(_boundingBox.width() > 0.0) || !(_boundingBox.height() > 0.0))
+    {
+        _edges = std::move(edges);
+        return;
+    }
+    buildGrid(edges);
+}
+
+void PolygonIndex::containsPoints(const Point *points, size_t count, bool *results) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        results[i] = containsPoint(points[i].x, points[i].y);
+    }
+}
+
+void PolygonIndex::buildGrid(const std::vector<Edge> &edges)
+{
+    size_t targetCellCount = std::min(std::max(edges.size() * kCellsPerVertex, kMinimumCellCount), kMaximumCellCount);
+    double aspect = _boundingBox.width() / _boundingBox.height();
+    double columns = std::sqrt(static_cast<double>(targetCellCount) * aspect);
+    _columnCount = static_cast<size_t>(std::min(std::max(std::ceil(columns), 1.0), static_cast<double>(targetCellCount)));
+    _rowCount = std::max<size_t>(1, (targetCellCount + _columnCount - 1) / _columnCount);
+    double cellWidth = _boundingBox.width() / _columnCount;
+    double cellHeight = _boundingBox.height() / _rowCount;
+    _inverseCellWidth = 1.0 / cellWidth;
+    _inverseCellHeight = 1.0 / cellHeight;
+
+    auto columnOf = [this](double x) {
+        double column = std::floor((x - _boundingBox.minX) * _inverseCellWidth);
+        return static_cast<size_t>(std::min(std::max(column, 0.0), static_cast<double>(_columnCount - 1)));
+    };
+    auto rowOf = [this](double y) {
+        double row = std::floor((y - _boundingBox.minY) * _inverseCellHeight);
+        return static_cast<size_t>(std::min(std::max(row, 0.0), static_cast<double>(_rowCount - 1)));
+    };
+
+    _cells.assign(_columnCount * _rowCount, kOutsideCell);
+    std::vector<std::vector<Edge>> rowEdges(_rowCount);
+    for (const Edge &edge : edges)
+    {
+        double edgeMinY = std::min(edge.a.y, edge.b.y) - kBoundaryMargin;
+        double edgeMaxY = std::max(edge.a.y, edge.b.y) + kBoundaryMargin;
+        for (size_t row = rowOf(edgeMinY), lastRow = rowOf(edgeMaxY); row <= lastRow; row++)
+        {
+            rowEdges[row].push_back(edge);
+
+            // Part of the edge within the row, widened by the margin, marks the cells it passes through.
+            double rowMinY = std::max(_boundingBox.minY + row * cellHeight - kBoundaryMargin, edgeMinY);
+            double rowMaxY = std::min(_boundingBox.minY + (row + 1) * cellHeight + kBoundaryMargin, edgeMaxY);
+            double minX = std::min(edge.a.x, edge.b.x);
+            double maxX = std::max(edge.a.x, edge.b.x);
+            if (edge.a.y != edge.b.y)
+            {
+                double slope = (edge.b.x - edge.a.x) / (edge.b.y - edge.a.y);
+                double x1 = edge.a.x + (rowMinY - edge.a.y) * slope;
+                double x2 = edge.a.x + (rowMaxY - edge.a.y) * slope;
+                minX = std::max(minX, std::min(x1, x2));
+                maxX = std::min(maxX, std::max(x1, x2));
+            }
+            for (size_t column = columnOf(minX - kBoundaryMargin), lastColumn = columnOf(maxX + kBoundaryMargin);
+                 column <= lastColumn; column++)
+            {
+                _cells[row * _columnCount + column] = kBoundaryCell;
+            }
+        }
+    }
+
+    _edgeOffsets.reserve(_cells.size() + 1);
+    for (size_t row = 0; row < _rowCount; row++)
+    {
+        const std::vector<Edge> &edgesOfRow = rowEdges[row];
+        double rowMinY = _boundingBox.minY + row * cellHeight;
+        double rowMaxY = rowMinY + cellHeight;
+        for (size_t column = 0; column < _columnCount; column++)
+        {
+            uint8_t &cell = _cells[row * _columnCount + column];
+            _edgeOffsets.push_back(static_cast<uint32_t>(_edges.size()));
+            double cellMinX = _boundingBox.minX + column * cellWidth;
+            double cellMaxX = cellMinX + cellWidth;
+            if (cell != kBoundaryCell)
+            {
+                // Cells not crossed by the boundary are entirely inside or entirely outside; their centers tell which.
+                bool inside = containsPointInEdges(cellMinX + cellWidth / 2.0, rowMinY + cellHeight / 2.0,
+                                                   edgesOfRow.data(), edgesOfRow.size());
+                cell = inside ? kInsideCell : kOutsideCell;
+                continue;
+            }
+
+            bool crossedAnyway = false;
+            for (const Edge &edge : edgesOfRow)
+            {
+                // Edges left of the cell are never crossed by a ray cast to the right.
+                if (std::max(edge.a.x, edge.b.x) + kBoundaryMargin < cellMinX)
+                {
+                    continue;
+                }
+                // Edges right of the cell spanning the whole row are crossed from every point in the cell.
+                if (std::min(edge.a.x, edge.b.x) - kBoundaryMargin > cellMaxX
+                    && std::min(edge.a.y, edge.b.y) + kBoundaryMargin < rowMinY
+                    && std::max(edge.a.y, edge.b.y) - kBoundaryMargin > rowMaxY)
+                {
+                    crossedAnyway = !crossedAnyway;
+                    continue;
+                }
+                _edges.push_back(edge);
+            }
+            cell = crossedAnyway ? kBoundaryCellCrossed : kBoundaryCell;
+        }
+    }
+    _edgeOffsets.push_back(static_cast<uint32_t>(_edges.size()));
+}
+
+} // namespace eil
@@ -0,0 +1,200 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PolygonSampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eil {
+
+namespace {
+
+/** Twice the signed area of the triangle; positive if it turns counter clockwise. */
+double cross(const Point &a, const Point &b, const Point &c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/** Whether the point is inside the counter clockwise triangle or on its boundary. */
+bool triangleContains(const Point &a, const Point &b, const Point &c, const Point &point)
+{
+    return cross(a, b, point) >= 0.0 && cross(b, c, point) >= 0.0 && cross(c, a, point) >= 0.0;
+}
+
+} // namespace
+
+PolygonSampler::PolygonSampler(const std::vector<Point> &polygon)
+{
+    if (polygon.size() < 3)
+    {
+        return;
+    }
+
+    // Ear clipping below expects counter clockwise vertices.
+    std::vector<Point> vertices = polygon;
+    double signedArea = 0.0;
+    for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++)
+    {
+        signedArea += vertices[j].x * vertices[i].y - vertices[i].x * vertices[j].y;
+    }
+    if (signedArea < 0.0)
+    {
+        std::reverse(vertices.begin(), vertices.end());
+    }
+    double polygonArea = std::fabs(signedArea) / 2.0;
+
+    std::vector<size_t> remaining(vertices.size());
+    for (size_t i = 0; i < remaining.size(); i++)
+    {
+        remaining[i] = i;
+    }
+    std::vector<double> areas;
+    std::vector<Triangle> triangles;
+    triangles.reserve(vertices.size() - 2);
+    areas.reserve(vertices.size() - 2);
+    while (remaining.size() > 3)
+    {
+        size_t count = remaining.size();
+        bool clipped = false;
+        for (size_t i = 0; i < count && !clipped; i++)
+        {
+            const Point &previous = vertices[remaining[(i + count - 1) % count]];
+            const Point &current = vertices[remaining[i]];
+            const Point &next = vertices[remaining[(i + 1) % count]];
+            double turn = cross(previous, current, next);
+            if (turn < 0.0)
+            {
+                continue;
+            }
+            // A collinear vertex adds nothing but would block its neighbours; it is dropped without a triangle.
+            bool isEar = true;
+            if (turn > 0.0)
+            {
+                for (size_t k = 0; k < count && isEar; k++)
+                {
+                    const Point &other = vertices[remaining[k]];
+                    if (other != previous && other != current && other != next
+                        && triangleContains(previous, current, next, other))
+                    {
+                        isEar = false;
+                    }
+                }
+                if (isEar)
+                {
+                    triangles.push_back(Triangle{previous,
+                                                 Point(current.x - previous.x, current.y - previous.y),
+                                                 Point(next.x - previous.x, next.y - previous.y)});
+                    areas.push_back(turn / 2.0);
+                }
+            }
+            if (isEar)
+            {
+                remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>(i));
+                clipped = true;
+            }
+        }
+        if (!clipped)
+        {
+            // Only self-intersecting polygons run out of ears.
+            return;
+        }
+    }
+    double lastTurn = cross(vertices[remaining[0]], vertices[remaining[1]], vertices[remaining[2]]);
+    if (lastTurn > 0.0)
+    {
+        const Point &a = vertices[remaining[0]];
+        triangles.push_back(Triangle{a,
+                                     Point(vertices[remaining[1]].x - a.x, vertices[remaining[1]].y - a.y),
+                                     Point(vertices[remaining[2]].x - a.x, vertices[remaining[2]].y - a.y)});
+        areas.push_back(lastTurn / 2.0);
+    }
+
+    double area = 0.0;
+    for (double triangleArea : areas)
+    {
+        area += triangleArea;
+    }
+    // Triangles of a simple polygon add up to its area; anything else means the polygon crosses itself.
+    if (triangles.empty() || std::fabs(area - polygonArea) > 1e-9 * std::max(1.0, polygonArea))
+    {
+        return;
+    }
+    _triangles = std::move(triangles);
+    _area = area;
+    buildAliasTable(areas);
+}
+
+Point PolygonSampler::sample(Random &random) const
+{
+    if (_triangles.empty())
+    {
+        return Point();
+    }
+    double pick = random.uniform() * _triangles.size();
+    size_t index = std::min(static_cast<size_t>(pick), _triangles.size() - 1);
+    if (random.uniform() >= _keepProbabilities[index])
+    {
+        index = _aliases[index];
+    }
+
+    // Points beyond the diagonal are folded back, which keeps them uniform over the triangle.
+    double s = random.uniform();
+    double t = random.uniform();
+    if (s + t > 1.0)
+    {
+        s = 1.0 - s;
+        t = 1.0 - t;
+    }
+    const Triangle &triangle = _triangles[index];
+    return Point(triangle.a.x + s * triangle.ab.x + t * triangle.ac.x, triangle.a.y + s * triangle.ab.y + t * triangle.ac.y);
+}
+
+void PolygonSampler::sample(Random &random, Point *points, size_t count) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        points[i] = sample(random);
+    }
+}
+
+void PolygonSampler::buildAliasTable(const std::vector<double> &areas)
+{
+    // Vose's alias method: every slot keeps its own triangle with some probability and otherwise one alias.
+    size_t count = areas.size();
+    _keepProbabilities.assign(count, 1.0);
+    _aliases.resize(count);
+    std::vector<double> scaled(count);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (size_t i = 0; i < count; i++)
+    {
+        _aliases[i] = static_cast<uint32_t>(i);
+        scaled[i] = areas[i] * count / _area;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty())
+    {
+        uint32_t less = small.back();
+        small.pop_back();
+        uint32_t more = large.back();
+        _keepProbabilities[less] = scaled[less];
+        _aliases[less] = more;
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+    // Whatever is left is 1 up to rounding errors.
+    for (uint32_t index : small)
+    {
+        _keepProbabilities[index] = 1.0;
+    }
+    for (uint32_t index : large)
+    {
+        _keepProbabilities[index] = 1.0;
+    }
+}
+
+} // namespace eil
@@ -0,0 +1,50 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PositionBatch.hpp"
+
+#include <cmath>
+
+namespace eil {
+
+void PositionBatch::setPolicy(const BatchingPolicy &policy)
+{
+    _policy = policy;
+    if (_policy.maximumCount > _updates.capacity())
+    {
+        _updates.reserve(_policy.maximumCount);
+    }
+}
+
+double PositionBatch::distance() const
+{
+    if (_updates.empty())
+    {
+        return 0.0;
+    }
+    const Point &first = _updates.front().position;
+    const Point &last = _updates.back().position;
+    return std::hypot(last.x - first.x, last.y - first.y);
+}
+
+bool PositionBatch::isDue(double timestamp) const
+{
+    if (_updates.empty())
+    {
+        return false;
+    }
+    if (_policy.maximumCount == 0 && _policy.maximumLatency <= 0.0 && _policy.maximumDistance <= 0.0)
+    {
+        return true;
+    }
+    if (_policy.maximumCount > 0 && _updates.size() >= _policy.maximumCount)
+    {
+        return true;
+    }
+    if (_policy.maximumDistance > 0.0 && distance() >= _policy.maximumDistance)
+    {
+        return true;
+    }
+    return _policy.maximumLatency > 0.0 && timestamp - _updates.front().timestamp >= _policy.maximumLatency;
+}
+
+} // namespace eil
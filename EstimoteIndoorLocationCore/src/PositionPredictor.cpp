@@ -0,0 +1,84 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PositionPredictor.hpp"
+
+#include <algorithm>
+
+namespace eil {
+
+namespace {
+
+/** Weight of the previous velocity when a new update arrives; damps the jitter of consecutive estimates. */
+constexpr double kVelocitySmoothing = 0.5;
+
+/** Updates closer in time than this do not change the velocity, their displacement is dominated by noise. */
+constexpr double kMinimumVelocityInterval = 0.05;
+
+} // namespace
+
+PositionPredictor::PositionPredictor(LocationRef location, double maximumHorizon)
+    : _location(std::move(location)),
+      _walls(_location->segmentIndex()),
+      _maximumHorizon(maximumHorizon)
+{
+}
+
+bool PositionPredictor::predictedPositionAt(double timestamp, PositionUpdate &prediction) const
+{
+    State state = _published.load();
+    if (!state.valid)
+    {
+        return false;
+    }
+
+    prediction = state.update;
+    double elapsed = std::min(std::max(0.0, timestamp - state.update.timestamp), _maximumHorizon);
+    double x = state.update.position.x + state.velocityX * elapsed;
+    double y = state.update.position.y + state.velocityY * elapsed;
+    // Walls are not crossed; the avatar waits at the last update until the filter confirms where the user went.
+    Point last(state.update.position.x, state.update.position.y);
+    if (_location->containsPoint(x, y) && !_walls.intersects(last, Point(x, y), kWallSegments))
+    {
+        prediction.position.x = x;
+        prediction.position.y = y;
+    }
+    prediction.timestamp = timestamp;
+    return true;
+}
+
+void PositionPredictor::addUpdate(const PositionUpdate &update, bool isStationary)
+{
+    if (isStationary)
+    {
+        _state.velocityX = 0.0;
+        _state.velocityY = 0.0;
+    }
+    else if (_state.valid)
+    {
+        double elapsed = update.timestamp - _state.update.timestamp;
+        if (elapsed >= kMinimumVelocityInterval && elapsed <= _maximumHorizon)
+        {
+            double velocityX = (update.position.x - _state.update.position.x) / elapsed;
+            double velocityY = (update.position.y - _state.update.position.y) / elapsed;
+            _state.velocityX = kVelocitySmoothing * _state.velocityX + (1.0 - kVelocitySmoothing) * velocityX;
+            _state.velocityY = kVelocitySmoothing * _state.velocityY + (1.0 - kVelocitySmoothing) * velocityY;
+        }
+        else if (elapsed > _maximumHorizon)
+        {
+            // After a gap the old velocity says nothing about the current walk.
+            _state.velocityX = 0.0;
+            _state.velocityY = 0.0;
+        }
+    }
+    _state.valid = true;
+    _state.update = update;
+    _published.store(_state);
+}
+
+void PositionPredictor::reset()
+{
+    _state = State();
+    _published.store(_state);
+}
+
+} // namespace eil
@@ -0,0 +1,32 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PositionUpdate.hpp"
+
+namespace eil {
+
+PositionAccuracy accuracyForRadius(double radius)
+{
+    if (!(radius >= 0.0))
+    {
+        return PositionAccuracy::Unknown;
+    }
+    if (radius < 1.0)
+    {
+        return PositionAccuracy::VeryHigh;
+    }
+    if (radius < 1.62)
+    {
+        return PositionAccuracy::High;
+    }
+    if (radius < 2.62)
+    {
+        return PositionAccuracy::Medium;
+    }
+    if (radius < 4.24)
+    {
+        return PositionAccuracy::Low;
+    }
+    return PositionAccuracy::VeryLow;
+}
+
+} // namespace eil
@@ -0,0 +1,685 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PositioningEngine.hpp"
+
+#include "EILCore/LocationCoding.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace eil {
+
+namespace {
+
+bool isSameLocation(const Location &a, const Location &b)
+{
+    return &a == &b || (!a.identifier().empty() && a.identifier() == b.identifier());
+}
+
+double wallClockTime()
+{
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+PositioningEngine::PositioningEngine(const AlgorithmParameters &parameters)
+    : _parameters(parameters),
+      _beacons(parameters.rssiTimeConstant)
+{
+}
+
+PositioningEngine::PositioningEngine(LocationRef location, const AlgorithmParameters &parameters)
+    : PositioningEngine(parameters)
+{
+    startPositionUpdates(std::move(location));
+}
+
+void PositioningEngine::startPositionUpdates(LocationRef location)
+{
+    if (!location || sessionForLocation(*location) != nullptr)
+    {
+        return;
+    }
+
+    for (const PositionedBeacon &beacon : location->beacons())
+    {
+        _beaconReferences[beacon.beacon]++;
+    }
+    if (_traceWriter)
+    {
+        _traceWriter->writeLocation(*location);
+    }
+    _sessions.emplace_back(new LocationSession(std::move(location), _parameters));
+    _sessions.back()->batch.setPolicy(_batchingPolicy);
+    if (_signalMapCache)
+    {
+        LocationSession &session = *_sessions.back();
+        session.filter.setSignalMap(_signalMapCache->signalMapForLocation(*session.filter.location(), _parameters));
+    }
+    if (_started)
+    {
+        applyRestoredLocation(*_sessions.back());
+    }
+}
+
+void PositioningEngine::setSignalMapCache(std::shared_ptr<SignalMapCache> cache)
+{
+    _signalMapCache = std::move(cache);
+    for (const std::unique_ptr<LocationSession> &session : _sessions)
+    {
+        session->filter.setSignalMap(_signalMapCache
+                                     ? _signalMapCache->signalMapForLocation(*session->filter.location(), _parameters)
+                                     : nullptr);
+    }
+}
+
+void PositioningEngine::setPositionHandler(PositionHandler handler)
+{
+    _positionHandler = handler ? std::make_shared<const PositionHandler>(std::move(handler)) : nullptr;
+}
+
+void PositioningEngine::setBatchHandler(BatchHandler handler, const BatchingPolicy &policy)
+{
+    _batchHandler = handler ? std::make_shared<const BatchHandler>(std::move(handler)) : nullptr;
+    _batchingPolicy = policy;
+    for (const std::unique_ptr<LocationSession> &session : _sessions)
+    {
+        session->batch.setPolicy(policy);
+        if (!_batchHandler)
+        {
+            session->batch.clear();
+        }
+    }
+}
+
+void PositioningEngine::flushBatches()
+{
+    _dispatchDepth++;
+    size_t count = _sessions.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!_sessions[i]->stopped)
+        {
+            deliverBatch(*_sessions[i]);
+        }
+    }
+    endDispatch();
+}
+
+void PositioningEngine::deliverBatch(LocationSession &session)
+{
+    if (session.batch.empty() || session.deliveringBatch || !_batchHandler)
+    {
+        return;
+    }
+    // Deferred state changes ride along with the batch instead of waking the app up on their own.
+    if (_delegateQueue)
+    {
+        // Taken out of the monitor here, which is not thread-safe, and handed over on the queue just before the batch.
+        std::vector<GeofenceMonitor::StateChange> stateChanges;
+        std::shared_ptr<const GeofenceMonitor::StateHandler> stateHandler;
+        if (_geofenceMonitor)
+        {
+            _geofenceMonitor->takeStateChanges(stateChanges);
+            stateHandler = _geofenceMonitor->stateHandler();
+        }
+        std::shared_ptr<const BatchHandler> handler = _batchHandler;
+        std::vector<PositionUpdate> updates(session.batch.data(), session.batch.data() + session.batch.size());
+        LocationRef location = session.filter.location();
+        session.batch.clear();
+        _delegateQueue->async([handler, updates, location, stateHandler, stateChanges] {
+            if (stateHandler)
+            {
+                for (const GeofenceMonitor::StateChange &change : stateChanges)
+                {
+                    (*stateHandler)(change.state, *change.location);
+                }
+            }
+            (*handler)(updates.data(), updates.size(), *location);
+        });
+        return;
+    }
+    if (_geofenceMonitor)
+    {
+        _geofenceMonitor->flushStateChanges();
+    }
+
+    // The handler may stop the location, which would hand over the very same batch again.
+    _dispatchDepth++;
+    session.deliveringBatch = true;
+    (*_batchHandler)(session.batch.data(), session.batch.size(), *session.filter.location());
+    session.deliveringBatch = false;
+    session.batch.clear();
+    endDispatch();
+}
+
+void PositioningEngine::dispatchPositionUpdate(const PositionUpdate &update, const LocationRef &location,
+                                               PositionUpdateTiming timing)
+{
+    if (!_positionHandler)
+    {
+        if (_metrics)
+        {
+            timing.dispatched = timing.stepFinished;
+            timing.handlerFinished = timing.stepFinished;
+            _metrics->recordUpdate(timing);
+        }
+        return;
+    }
+    if (_delegateQueue)
+    {
+        std::shared_ptr<const PositionHandler> handler = _positionHandler;
+        std::shared_ptr<PositioningMetrics> metrics = _metrics;
+        _delegateQueue->async([handler, update, location, metrics, timing]() mutable {
+            if (metrics)
+            {
+                timing.dispatched = PositioningMetrics::now();
+            }
+            (*handler)(update, *location);
+            if (metrics)
+            {
+                timing.handlerFinished = PositioningMetrics::now();
+                metrics->recordUpdate(timing);
+            }
+        });
+        return;
+    }
+    // Kept alive locally, the handler may disable metrics.
+    std::shared_ptr<PositioningMetrics> metrics = _metrics;
+    if (metrics)
+    {
+        timing.dispatched = PositioningMetrics::now();
+    }
+    (*_positionHandler)(update, *location);
+    if (metrics)
+    {
+        timing.handlerFinished = PositioningMetrics::now();
+        metrics->recordUpdate(timing);
+    }
+}
+
+void PositioningEngine::endDispatch()
+{
+    if (--_dispatchDepth == 0)
+    {
+        removeStoppedSessions();
+    }
+}
+
+void PositioningEngine::stopPositionUpdates(const Location &location)
+{
+    LocationSession *session = sessionForLocation(location);
+    if (session == nullptr)
+    {
+        return;
+    }
+    deliverBatch(*session);
+    if (session->stopped)
+    {
+        return;
+    }
+    if (_traceWriter)
+    {
+        _traceWriter->writeLocationStop(*session->filter.location());
+    }
+
+    for (const PositionedBeacon &beacon : session->filter.location()->beacons())
+    {
+        auto reference = _beaconReferences.find(beacon.beacon);
+        if (reference != _beaconReferences.end() && --reference->second <= 0)
+        {
+            _beaconReferences.erase(reference);
+        }
+    }
+    session->stopped = true;
+    if (_dispatchDepth == 0)
+    {
+        removeStoppedSessions();
+    }
+}
+
+void PositioningEngine::stopPositionUpdates()
+{
+    flushBatches();
+    for (const std::unique_ptr<LocationSession> &session : _sessions)
+    {
+        if (_traceWriter && !session->stopped)
+        {
+            _traceWriter->writeLocationStop(*session->filter.location());
+        }
+        session->stopped = true;
+    }
+    _beaconReferences.clear();
+    if (_dispatchDepth == 0)
+    {
+        removeStoppedSessions();
+    }
+}
+
+void PositioningEngine::removeStoppedSessions()
+{
+    _sessions.erase(std::remove_if(_sessions.begin(), _sessions.end(), [](const std::unique_ptr<LocationSession> &session) {
+        return session->stopped;
+    }), _sessions.end());
+}
+
+std::vector<LocationRef> PositioningEngine::locations() const
+{
+    std::vector<LocationRef> locations;
+    locations.reserve(_sessions.size());
+    for (const std::unique_ptr<LocationSession> &session : _sessions)
+    {
+        if (!session->stopped)
+        {
+            locations.push_back(session->filter.location());
+        }
+    }
+    return locations;
+}
+
+void PositioningEngine::processSample(const BeaconSample &sample)
+{
+    if (_traceWriter)
+    {
+        _traceWriter->writeBeaconSample(sample);
+    }
+    _clock = std::max(_clock, sample.timestamp);
+    if (_geofenceMonitor)
+    {
+        _geofenceMonitor->processSample(sample);
+    }
+    if (_beaconReferences.find(sample.beacon) == _beaconReferences.end())
+    {
+        return;
+    }
+
+    if (!_started)
+    {
+        _started = true;
+        _nextStepTimestamp = sample.timestamp + _parameters.updateInterval;
+        applyRestoredBeacons();
+        for (const std::unique_ptr<LocationSession> &session : _sessions)
+        {
+            applyRestoredLocation(*session);
+        }
+    }
+    runDueSteps(sample.timestamp);
+    _beacons.addSample(sample);
+    if (_metrics)
+    {
+        _sampleReceivedAt = PositioningMetrics::now();
+    }
+}
+
+void PositioningEngine::processSensorSample(const SensorSample &sample)
+{
+    if (_traceWriter)
+    {
+        _traceWriter->writeSensorSample(sample);
+    }
+    if (_inertialFusion)
+    {
+        _inertialFusion->pushSample(sample);
+    }
+}
+
+void PositioningEngine::setTraceWriter(std::shared_ptr<TraceWriter> writer)
+{
+    _traceWriter = std::move(writer);
+    if (_traceWriter)
+    {
+        for (const std::unique_ptr<LocationSession> &session : _sessions)
+        {
+            _traceWriter->writeLocation(*session->filter.location());
+        }
+    }
+}
+
+void PositioningEngine::advanceTo(double timestamp)
+{
+    _clock = std::max(_clock, timestamp);
+    if (_geofenceMonitor)
+    {
+        _geofenceMonitor->advanceTo(timestamp);
+    }
+    if (_started)
+    {
+        runDueSteps(timestamp);
+    }
+}
+
+void PositioningEngine::setFloorDetector(std::shared_ptr<FloorDetector> detector)
+{
+    _floorDetector = std::move(detector);
+    if (_floorDetector)
+    {
+        for (const Floor &floor : _floorDetector->building()->floors())
+        {
+            startPositionUpdates(floor.location);
+        }
+    }
+}
+
+void PositioningEngine::reset()
+{
+    _beacons.reset();
+    if (_floorDetector)
+    {
+        _floorDetector->reset();
+    }
+    for (const std::unique_ptr<LocationSession> &session : _sessions)
+    {
+        session->filter.reset();
+        session->hasPosition = false;
+        session->hasEstimate = false;
+        session->predictor->reset();
+    }
+    _restoredSnapshot.reset();
+    _started = false;
+}
+
+bool PositioningEngine::saveSnapshot(const std::string &path) const
+{
+    PositioningSnapshot snapshot;
+    snapshot.savedAt = wallClockTime();
+    snapshot.timestamp = _clock;
+    snapshot.beacons.reserve(_beacons.count());
+    for (const auto &state : _beacons.states())
+    {
+        BeaconSnapshot beacon;
+        beacon.beacon = state.first;
+        beacon.state = state.second;
+        snapshot.beacons.push_back(beacon);
+    }
+    for (const std::unique_ptr<LocationSession> &session : _sessions)
+    {
+        const Location &location = *session->filter.location();
+        if (session->stopped || location.identifier().empty())
+        {
+            continue;
+        }
+        LocationSnapshot saved;
+        saved.identifier = location.identifier();
+        saved.fingerprint = locationFingerprint(location);
+        saved.hasPosition = session->hasPosition;
+        saved.lastUpdate = session->lastUpdate;
+        saved.filterTimestamp = session->filter.lastTimestamp();
+        saved.particles = session->filter.particles();
+        snapshot.locations.push_back(std::move(saved));
+    }
+    return writePositioningSnapshot(snapshot, path);
+}
+
+bool PositioningEngine::restoreSnapshot(const std::string &path, double maximumAge)
+{
+    std::unique_ptr<PositioningSnapshot> snapshot(new PositioningSnapshot());
+    if (!readPositioningSnapshot(path, *snapshot))
+    {
+        return false;
+    }
+    double age = wallClockTime() - snapshot->savedAt;
+    if (!(age <= maximumAge))
+    {
+        return false;
+    }
+
+    _restoredSnapshot = std::move(snapshot);
+    if (_started)
+    {
+        applyRestoredBeacons();
+        for (const std::unique_ptr<LocationSession> &session : _sessions)
+        {
+            applyRestoredLocation(*session);
+        }
+    }
+    return true;
+}
+
+double PositioningEngine::restoredTimeOffset() const
+{
+    // Moves times of the snapshot onto the clock of this engine. Time spent in between is measured with the wall clock,
+    // as the clock of the samples is not guaranteed to survive a restart.
+    double elapsed = std::max(0.0, wallClockTime() - _restoredSnapshot->savedAt);
+    return _clock - elapsed - _restoredSnapshot->timestamp;
+}
+
+void PositioningEngine::applyRestoredBeacons()
+{
+    if (!_restoredSnapshot || _restoredSnapshot->beacons.empty())
+    {
+        return;
+    }
+    double offset = restoredTimeOffset();
+    for (const BeaconSnapshot &beacon : _restoredSnapshot->beacons)
+    {
+        // Keeping the original first sighting lets locations warm up as soon as the beacon is heard again.
+        // Beacons that are not heard again are dropped as stale by the next update.
+        if (_beacons.stateForBeacon(beacon.beacon) == nullptr)
+        {
+            BeaconState state = beacon.state;
+            state.firstSeen += offset;
+            state.lastSeen += offset;
+            _beacons.restoreState(beacon.beacon, state);
+        }
+    }
+    _restoredSnapshot->beacons.clear();
+}
+
+void PositioningEngine::applyRestoredLocation(LocationSession &session)
+{
+    if (!_restoredSnapshot)
+    {
+        return;
+    }
+    const Location &location = *session.filter.location();
+    std::vector<LocationSnapshot> &locations = _restoredSnapshot->locations;
+    auto saved = std::find_if(locations.begin(), locations.end(), [&location](const LocationSnapshot &snapshot) {
+        return !location.identifier().empty() && snapshot.identifier == location.identifier();
+    });
+    if (saved == locations.end())
+    {
+        return;
+    }
+
+    if (saved->fingerprint == locationFingerprint(location))
+    {
+        double offset = restoredTimeOffset();
+        // The motion model spreads restored particles by the time elapsed since, which is pointless once the user
+        // could have crossed the whole location; the filter then starts from scratch, just without the warm-up.
+        const Rect &box = location.boundingBox();
+        double reach = _parameters.maxWalkingSpeed * (_clock - (saved->filterTimestamp + offset)) / 2.0;
+        if (reach * reach < box.width() * box.width() + box.height() * box.height())
+        {
+            session.filter.restoreParticles(saved->particles, saved->filterTimestamp + offset);
+        }
+        if (saved->hasPosition && !session.hasPosition)
+        {
+            session.hasPosition = true;
+            session.lastUpdate = saved->lastUpdate;
+            session.lastUpdate.timestamp += offset;
+            session.predictor->addUpdate(session.lastUpdate, true);
+            if (!session.hasEstimate)
+            {
+                session.hasEstimate = true;
+                session.lastEstimate = session.lastUpdate;
+            }
+        }
+    }
+    locations.erase(saved);
+    if (locations.empty() && _restoredSnapshot->beacons.empty())
+    {
+        _restoredSnapshot.reset();
+    }
+}
+
+const PositionUpdate *PositioningEngine::lastUpdate(const Location &location) const
+{
+    const LocationSession *session = sessionForLocation(location);
+    return session != nullptr && session->hasPosition ? &session->lastUpdate : nullptr;
+}
+
+bool PositioningEngine::predictedPositionAt(const Location &location, double timestamp, PositionUpdate &prediction) const
+{
+    const LocationSession *session = sessionForLocation(location);
+    return session != nullptr && session->predictor->predictedPositionAt(timestamp, prediction);
+}
+
+std::shared_ptr<const PositionPredictor> PositioningEngine::positionPredictor(const Location &location) const
+{
+    const LocationSession *session = sessionForLocation(location);
+    return session != nullptr ? session->predictor : nullptr;
+}
+
+PositioningEngine::LocationSession *PositioningEngine::sessionForLocation(const Location &location)
+{
+    for (const std::unique_ptr<LocationSession> &session : _sessions)
+    {
+        if (!session->stopped && isSameLocation(*session->filter.location(), location))
+        {
+            return session.get();
+        }
+    }
+    return nullptr;
+}
+
+const PositioningEngine::LocationSession *PositioningEngine::sessionForLocation(const Location &location) const
+{
+    return const_cast<PositioningEngine *>(this)->sessionForLocation(location);
+}
+
+bool PositioningEngine::isInactiveFloor(const Location &location) const
+{
+    if (!_floorDetector)
+    {
+        return false;
+    }
+    int floor = _floorDetector->building()->indexOfLocation(location);
+    return floor >= 0 && floor != _floorDetector->currentFloorIndex();
+}
+
+bool PositioningEngine::isWarmedUp(const Location &location, double timestamp) const
+{
+    for (const PositionedBeacon &beacon : location.beacons())
+    {
+        const BeaconState *state = _beacons.stateForBeacon(beacon.beacon);
+        if (state != nullptr && timestamp - state->firstSeen >= _parameters.warmUpDuration)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PositioningEngine::runDueSteps(double timestamp)
+{
+    if (timestamp < _nextStepTimestamp)
+    {
+        return;
+    }
+    // After a gap longer than a single interval only one step is run; intermediate updates would carry no new information.
+    double stepTimestamp = timestamp - _nextStepTimestamp >= _parameters.updateInterval ? timestamp : _nextStepTimestamp;
+    runStep(stepTimestamp);
+    _nextStepTimestamp = stepTimestamp + _parameters.updateInterval;
+}
+
+void PositioningEngine::runStep(double timestamp)
+{
+    _beacons.removeStaleBeacons(timestamp, _parameters.beaconTimeout);
+
+    MotionState motion;
+    const MotionState *currentMotion = nullptr;
+    if (_inertialFusion)
+    {
+        motion = _inertialFusion->motionState();
+        // Sensors may stall or lag behind the beacons; an outdated state would pin the user in place.
+        if (motion.timestamp > 0.0 && std::abs(timestamp - motion.timestamp) <= _parameters.beaconTimeout)
+        {
+            currentMotion = &motion;
+        }
+    }
+
+    if (_floorDetector)
+    {
+        const Floor *previousFloor = _floorDetector->currentFloor();
+        LocationRef previousLocation = previousFloor != nullptr ? previousFloor->location : nullptr;
+        if (_floorDetector->update(timestamp, _beacons, _parameters.beaconTimeout, currentMotion) && previousLocation)
+        {
+            LocationSession *previousSession = sessionForLocation(*previousLocation);
+            if (previousSession != nullptr)
+            {
+                deliverBatch(*previousSession);
+            }
+        }
+    }
+
+    // Handlers may start or stop position updates. Sessions started meanwhile are stepped from the next update on,
+    // stopped ones are removed once all sessions were stepped.
+    _dispatchDepth++;
+    size_t count = _sessions.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        LocationSession *session = _sessions[i].get();
+        if (session->stopped)
+        {
+            continue;
+        }
+        const Location &location = *session->filter.location();
+        PositionUpdateTiming timing;
+        if (_metrics)
+        {
+            timing.sampleReceived = _sampleReceivedAt;
+            timing.stepStarted = PositioningMetrics::now();
+        }
+        int usedBeacons = session->filter.step(timestamp, _beacons, currentMotion);
+        if (usedBeacons == 0 || !isWarmedUp(location, timestamp))
+        {
+            if (session->batch.isDue(timestamp))
+            {
+                deliverBatch(*session);
+            }
+            continue;
+        }
+
+        PositionUpdate update = session->filter.estimate();
+        update.position.orientation = kOrientationUndefined;
+        if (_parameters.provideOrientation && session->hasEstimate)
+        {
+            const PositionUpdate &last = session->lastEstimate;
+            double dX = update.position.x - last.position.x;
+            double dY = update.position.y - last.position.y;
+            double minimum = _parameters.minimumDisplacementForOrientation;
+            update.position.orientation = dX * dX + dY * dY >= minimum * minimum
+                                          ? orientationForDirection(dX, dY)
+                                          : last.position.orientation;
+        }
+
+        session->hasEstimate = true;
+        session->lastEstimate = update;
+        // Other floors only keep their estimates converged for a fast handoff; nothing is delivered or predicted.
+        if (isInactiveFloor(location))
+        {
+            continue;
+        }
+        session->hasPosition = true;
+        session->lastUpdate = update;
+        session->predictor->addUpdate(update, currentMotion != nullptr && !currentMotion->isMoving);
+        if (_metrics)
+        {
+            timing.stepFinished = PositioningMetrics::now();
+        }
+        dispatchPositionUpdate(update, session->filter.location(), timing);
+        if (_batchHandler && !session->stopped)
+        {
+            session->batch.append(update);
+            if (session->batch.isDue(timestamp))
+            {
+                deliverBatch(*session);
+            }
+        }
+    }
+    endDispatch();
+}
+
+} // namespace eil
@@ -0,0 +1,233 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PositioningMetrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace eil {
+
+namespace {
+
+/** Bucket 0 holds latencies below 1 µs, bucket i > 0 latencies in [2^((i - 1) / 4), 2^(i / 4)) µs. */
+int bucketForLatency(double seconds)
+{
+    double microseconds = seconds * 1e6;
+    if (!(microseconds >= 1.0))
+    {
+        return 0;
+    }
+    int bucket = 1 + static_cast<int>(std::log2(microseconds) * LatencyHistogram::kBucketsPerOctave);
+    return std::min(bucket, LatencyHistogram::kBucketCount - 1);
+}
+
+/** Geometric center of the bucket, in seconds. */
+double latencyForBucket(int bucket)
+{
+    if (bucket == 0)
+    {
+        return 0.5e-6;
+    }
+    return std::exp2((bucket - 0.5) / LatencyHistogram::kBucketsPerOctave) * 1e-6;
+}
+
+void appendSummary(std::string &json, const char *name, const LatencySummary &summary)
+{
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "\"%s\":{\"count\":%llu,\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}",
+                  name, static_cast<unsigned long long>(summary.count), summary.mean * 1e3, summary.p50 * 1e3,
+                  summary.p90 * 1e3, summary.p99 * 1e3, summary.max * 1e3);
+    json += buffer;
+}
+
+} // namespace
+
+constexpr int LatencyHistogram::kBucketsPerOctave;
+constexpr int LatencyHistogram::kBucketCount;
+
+void LatencyHistogram::record(double seconds)
+{
+    seconds = std::max(0.0, seconds);
+    _buckets[bucketForLatency(seconds)]++;
+    _count++;
+    _sum += seconds;
+    _max = std::max(_max, seconds);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < kBucketCount; i++)
+    {
+        _buckets[i] += other._buckets[i];
+    }
+    _count += other._count;
+    _sum += other._sum;
+    _max = std::max(_max, other._max);
+}
+
+void LatencyHistogram::reset()
+{
+    _buckets.fill(0);
+    _count = 0;
+    _sum = 0.0;
+    _max = 0.0;
+}
+
+double LatencyHistogram::percentile(double fraction) const
+{
+    if (_count == 0)
+    {
+        return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(1.0, std::max(0.0, fraction)) * _count));
+    uint64_t cumulative = 0;
+    for (int i = 0; i < kBucketCount; i++)
+    {
+        cumulative += _buckets[i];
+        if (cumulative >= std::max<uint64_t>(1, rank))
+        {
+            // The bucket center can overshoot the largest latency actually seen.
+            return std::min(latencyForBucket(i), _max);
+        }
+    }
+    return _max;
+}
+
+PositioningMetrics::PositioningMetrics(double window, int slices)
+    : _slices(static_cast<size_t>(std::max(1, slices)))
+{
+    _sliceDuration = std::max(1e-3, window) / _slices.size();
+    _slices[0].start = now();
+}
+
+double PositioningMetrics::now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PositioningMetrics::recordUpdate(const PositionUpdateTiming &timing)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    rotate(now());
+    Slice &slice = _slices[_currentSlice];
+    slice.stages[StageEndToEnd].record(timing.dispatched - timing.sampleReceived);
+    slice.stages[StageStep].record(timing.stepFinished - timing.stepStarted);
+    slice.stages[StageDispatch].record(timing.dispatched - timing.stepFinished);
+    slice.stages[StageHandler].record(timing.handlerFinished - timing.dispatched);
+    _lastTiming = timing;
+    _totalUpdateCount++;
+}
+
+PositionUpdateTiming PositioningMetrics::lastTiming() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _lastTiming;
+}
+
+uint64_t PositioningMetrics::totalUpdateCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _totalUpdateCount;
+}
+
+LatencySummary PositioningMetrics::endToEnd() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return summary(StageEndToEnd);
+}
+
+LatencySummary PositioningMetrics::step() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return summary(StageStep);
+}
+
+LatencySummary PositioningMetrics::dispatch() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return summary(StageDispatch);
+}
+
+LatencySummary PositioningMetrics::handler() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return summary(StageHandler);
+}
+
+std::string PositioningMetrics::exportJSON() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "{\"window\":%.1f,\"updates\":%llu,", _sliceDuration * _slices.size(),
+                  static_cast<unsigned long long>(_totalUpdateCount));
+    std::string json = buffer;
+    appendSummary(json, "endToEnd", summary(StageEndToEnd));
+    json += ",";
+    appendSummary(json, "step", summary(StageStep));
+    json += ",";
+    appendSummary(json, "dispatch", summary(StageDispatch));
+    json += ",";
+    appendSummary(json, "handler", summary(StageHandler));
+    json += "}";
+    return json;
+}
+
+void PositioningMetrics::reset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (Slice &slice : _slices)
+    {
+        for (LatencyHistogram &histogram : slice.stages)
+        {
+            histogram.reset();
+        }
+    }
+    _currentSlice = 0;
+    _slices[0].start = now();
+    _lastTiming = PositionUpdateTiming();
+    _totalUpdateCount = 0;
+}
+
+void PositioningMetrics::rotate(double timestamp) const
+{
+    double elapsed = timestamp - _slices[_currentSlice].start;
+    if (elapsed < _sliceDuration)
+    {
+        return;
+    }
+    // Slices are reused in a ring; each one skipped over is emptied, and after a whole window of silence all of them are.
+    size_t skipped = std::min(static_cast<size_t>(elapsed / _sliceDuration), _slices.size());
+    double start = _slices[_currentSlice].start + std::floor(elapsed / _sliceDuration) * _sliceDuration;
+    for (size_t i = 0; i < skipped; i++)
+    {
+        _currentSlice = (_currentSlice + 1) % _slices.size();
+        for (LatencyHistogram &histogram : _slices[_currentSlice].stages)
+        {
+            histogram.reset();
+        }
+    }
+    _slices[_currentSlice].start = start;
+}
+
+LatencySummary PositioningMetrics::summary(Stage stage) const
+{
+    rotate(now());
+    LatencyHistogram merged;
+    for (const Slice &slice : _slices)
+    {
+        merged.merge(slice.stages[stage]);
+    }
+    LatencySummary summary;
+    summary.count = merged.count();
+    summary.mean = merged.mean();
+    summary.p50 = merged.percentile(0.5);
+    summary.p90 = merged.percentile(0.9);
+    summary.p99 = merged.percentile(0.99);
+    summary.max = merged.max();
+    return summary;
+}
+
+} // namespace eil
@@ -0,0 +1,184 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/PositioningSnapshot.hpp"
+
+#include "BinaryCoding.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace eil {
+
+namespace {
+
+const char kSnapshotMagic[8] = {'E', 'I', 'L', 'S', 'N', 'A', 'P', 'S'};
+constexpr uint16_t kSnapshotVersion = 1;
+constexpr size_t kSnapshotHeaderLength = sizeof(kSnapshotMagic) + 4;
+
+/** Upper bounds that reject corrupted counts before anything is allocated for them. */
+constexpr uint64_t kMaximumBeaconCount = 100000;
+constexpr uint64_t kMaximumParticleCount = 1000000;
+
+void putPositionUpdate(ByteWriter &writer, const PositionUpdate &update)
+{
+    writer.putDouble(update.position.x);
+    writer.putDouble(update.position.y);
+    writer.putDouble(update.position.orientation);
+    writer.putUInt8(static_cast<uint8_t>(update.accuracy));
+    writer.putDouble(update.accuracyRadius);
+    writer.putDouble(update.timestamp);
+}
+
+PositionUpdate getPositionUpdate(ByteReader &reader)
+{
+    PositionUpdate update;
+    update.position.x = reader.getDouble();
+    update.position.y = reader.getDouble();
+    update.position.orientation = reader.getDouble();
+    uint8_t accuracy = reader.getUInt8();
+    update.accuracy = accuracy <= static_cast<uint8_t>(PositionAccuracy::Unknown)
+                      ? static_cast<PositionAccuracy>(accuracy)
+                      : PositionAccuracy::Unknown;
+    update.accuracyRadius = reader.getDouble();
+    update.timestamp = reader.getDouble();
+    return update;
+}
+
+} // namespace
+
+bool writePositioningSnapshot(const PositioningSnapshot &snapshot, const std::string &path)
+{
+    std::string buffer(kSnapshotMagic, sizeof(kSnapshotMagic));
+    ByteWriter writer(buffer);
+    writer.putUInt16(kSnapshotVersion);
+    writer.putUInt16(0);
+    writer.putDouble(snapshot.savedAt);
+    writer.putDouble(snapshot.timestamp);
+
+    writer.putVarUInt(snapshot.beacons.size());
+    for (const BeaconSnapshot &beacon : snapshot.beacons)
+    {
+        writer.putUInt64(beacon.beacon);
+        writer.putDouble(beacon.state.rssi);
+        writer.putDouble(beacon.state.variance);
+        writer.putDouble(beacon.state.firstSeen);
+        writer.putDouble(beacon.state.lastSeen);
+        writer.putVarUInt(beacon.state.sampleCount);
+    }
+
+    writer.putVarUInt(snapshot.locations.size());
+    for (const LocationSnapshot &location : snapshot.locations)
+    {
+        writer.putString(location.identifier);
+        writer.putUInt64(location.fingerprint);
+        writer.putUInt8(location.hasPosition ? 1 : 0);
+        putPositionUpdate(writer, location.lastUpdate);
+        writer.putDouble(location.filterTimestamp);
+        // Single precision is plenty for positions inside a building and halves the size of the snapshot.
+        writer.putVarUInt(location.particles.size());
+        for (const Particle &particle : location.particles)
+        {
+            writer.putFloat(static_cast<float>(particle.x));
+            writer.putFloat(static_cast<float>(particle.y));
+            writer.putFloat(static_cast<float>(particle.weight));
+        }
+    }
+
+    // Written next to the target and renamed over it, so readers never see a partially written snapshot.
+    std::string temporaryPath = path + ".tmp";
+    FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    bool written = std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool readPositioningSnapshot(const std::string &path, PositioningSnapshot &snapshot)
+{
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    std::string data;
+    char chunk[16 * 1024];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.append(chunk, read);
+    }
+    std::fclose(file);
+
+    if (data.size() < kSnapshotHeaderLength || std::memcmp(data.data(), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0)
+    {
+        return false;
+    }
+    ByteReader reader(reinterpret_cast<const uint8_t *>(data.data()) + sizeof(kSnapshotMagic),
+                      data.size() - sizeof(kSnapshotMagic));
+    if (reader.getUInt16() != kSnapshotVersion)
+    {
+        return false;
+    }
+    reader.getUInt16();
+
+    PositioningSnapshot result;
+    result.savedAt = reader.getDouble();
+    result.timestamp = reader.getDouble();
+
+    uint64_t beaconCount = reader.getVarUInt();
+    if (beaconCount > kMaximumBeaconCount)
+    {
+        return false;
+    }
+    result.beacons.resize(static_cast<size_t>(beaconCount));
+    for (BeaconSnapshot &beacon : result.beacons)
+    {
+        beacon.beacon = reader.getUInt64();
+        beacon.state.rssi = reader.getDouble();
+        beacon.state.variance = reader.getDouble();
+        beacon.state.firstSeen = reader.getDouble();
+        beacon.state.lastSeen = reader.getDouble();
+        beacon.state.sampleCount = static_cast<uint32_t>(reader.getVarUInt());
+    }
+
+    uint64_t locationCount = reader.getVarUInt();
+    while (locationCount-- > 0 && !reader.failed())
+    {
+        LocationSnapshot location;
+        location.identifier = reader.getString();
+        location.fingerprint = reader.getUInt64();
+        location.hasPosition = reader.getUInt8() != 0;
+        location.lastUpdate = getPositionUpdate(reader);
+        location.filterTimestamp = reader.getDouble();
+        uint64_t particleCount = reader.getVarUInt();
+        if (particleCount > kMaximumParticleCount || particleCount * 12 > reader.remaining())
+        {
+            return false;
+        }
+        location.particles.resize(static_cast<size_t>(particleCount));
+        for (Particle &particle : location.particles)
+        {
+            particle.x = reader.getFloat();
+            particle.y = reader.getFloat();
+            particle.weight = reader.getFloat();
+        }
+        result.locations.push_back(std::move(location));
+    }
+
+    if (reader.failed())
+    {
+        return false;
+    }
+    snapshot = std::move(result);
+    return true;
+}
+
+} // namespace eil
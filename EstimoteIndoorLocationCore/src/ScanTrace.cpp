@@ -0,0 +1,332 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/ScanTrace.hpp"
+
+#include "BinaryCoding.hpp"
+#include "EILCore/LocationCoding.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace eil {
+
+namespace {
+
+const char kTraceMagic[8] = {'E', 'I', 'L', 'T', 'R', 'A', 'C', 'E'};
+/** Version 2 added identifier strings to beacon definitions and location stop records. */
+constexpr uint16_t kTraceVersion = 2;
+constexpr uint16_t kOldestReadableTraceVersion = 1;
+constexpr size_t kTraceHeaderLength = sizeof(kTraceMagic) + 4;
+
+/** Size of the buffer after which records are written to the file. */
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+enum RecordTag : uint8_t
+{
+    RecordTagLocation = 1,
+    RecordTagBeaconDefinition = 2,
+    RecordTagBeaconSample = 3,
+    RecordTagSensorSample = 4,
+    RecordTagLocationStop = 5,
+};
+
+} // namespace
+
+TraceWriter::~TraceWriter()
+{
+    close();
+}
+
+bool TraceWriter::open(const std::string &path)
+{
+    close();
+    _file = std::fopen(path.c_str(), "wb");
+    if (_file == nullptr)
+    {
+        return false;
+    }
+
+    _buffer.clear();
+    _lastMicroseconds = 0;
+    _beaconIndices.clear();
+    _beaconIdentifiers.clear();
+    _locations.clear();
+
+    _buffer.append(kTraceMagic, sizeof(kTraceMagic));
+    ByteWriter writer(_buffer);
+    writer.putUInt16(kTraceVersion);
+    writer.putUInt16(0);
+    flush();
+    return true;
+}
+
+void TraceWriter::writeLocation(const Location &location)
+{
+    if (_file == nullptr)
+    {
+        return;
+    }
+    for (const PositionedBeacon &beacon : location.beacons())
+    {
+        _beaconIdentifiers.emplace(beacon.beacon, beacon.identifier);
+        // Apps ranging by proximity UUID report the iBeacon triple instead; it is the same physical beacon.
+        if (!beacon.proximityUUID.empty() && beacon.major >= 0 && beacon.minor >= 0)
+        {
+            _beaconIdentifiers.emplace(beaconIdFromIBeacon(beacon.proximityUUID, static_cast<uint16_t>(beacon.major),
+                                                           static_cast<uint16_t>(beacon.minor)),
+                                       beacon.identifier);
+        }
+    }
+    _locations.push_back(&location);
+
+    ByteWriter writer(_buffer);
+    writer.putUInt8(RecordTagLocation);
+    writer.putString(encodeLocation(location));
+    flushIfNeeded();
+}
+
+void TraceWriter::writeLocationStop(const Location &location)
+{
+    if (_file == nullptr)
+    {
+        return;
+    }
+    // The most recent record of the address is the live one; an older one may belong to a location freed since.
+    auto recorded = std::find(_locations.rbegin(), _locations.rend(), &location);
+    if (recorded == _locations.rend())
+    {
+        return;
+    }
+    ByteWriter writer(_buffer);
+    writer.putUInt8(RecordTagLocationStop);
+    writer.putVarUInt(static_cast<uint64_t>(_locations.rend() - recorded - 1));
+    flushIfNeeded();
+}
+
+void TraceWriter::writeBeaconSample(const BeaconSample &sample)
+{
+    if (_file == nullptr)
+    {
+        return;
+    }
+    ByteWriter writer(_buffer);
+    auto inserted = _beaconIndices.emplace(sample.beacon, static_cast<uint32_t>(_beaconIndices.size()));
+    if (inserted.second)
+    {
+        writer.putUInt8(RecordTagBeaconDefinition);
+        writer.putUInt64(sample.beacon);
+        auto identifier = _beaconIdentifiers.find(sample.beacon);
+        writer.putString(identifier != _beaconIdentifiers.end() ? identifier->second : std::string());
+    }
+
+    writer.putUInt8(RecordTagBeaconSample);
+    putTimestamp(sample.timestamp);
+    writer.putVarUInt(inserted.first->second);
+    writer.putUInt8(static_cast<uint8_t>(static_cast<int8_t>(std::max(-128, std::min(127, sample.rssi)))));
+    flushIfNeeded();
+}
+
+void TraceWriter::writeSensorSample(const SensorSample &sample)
+{
+    if (_file == nullptr)
+    {
+        return;
+    }
+    ByteWriter writer(_buffer);
+    writer.putUInt8(RecordTagSensorSample);
+    putTimestamp(sample.timestamp);
+    writer.putUInt8(static_cast<uint8_t>(sample.type));
+    writer.putFloat(sample.x);
+    writer.putFloat(sample.y);
+    writer.putFloat(sample.z);
+    flushIfNeeded();
+}
+
+void TraceWriter::putTimestamp(double timestamp)
+{
+    int64_t microseconds = std::llround(timestamp * 1e6);
+    ByteWriter(_buffer).putVarInt(microseconds - _lastMicroseconds);
+    _lastMicroseconds = microseconds;
+}
+
+void TraceWriter::flushIfNeeded()
+{
+    if (_buffer.size() >= kFlushThreshold)
+    {
+        flush();
+    }
+}
+
+void TraceWriter::flush()
+{
+    if (_file == nullptr)
+    {
+        return;
+    }
+    if (!_buffer.empty())
+    {
+        std::fwrite(_buffer.data(), 1, _buffer.size(), _file);
+        _buffer.clear();
+    }
+    std::fflush(_file);
+}
+
+void TraceWriter::close()
+{
+    if (_file == nullptr)
+    {
+        return;
+    }
+    flush();
+    std::fclose(_file);
+    _file = nullptr;
+}
+
+bool TraceReader::open(const std::string &path)
+{
+    _data.clear();
+    _offset = 0;
+    _version = 0;
+    _lastMicroseconds = 0;
+    _beacons.clear();
+    _beaconIdentifiers.clear();
+    _locations.clear();
+    _truncated = false;
+
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    uint8_t chunk[64 * 1024];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        _data.insert(_data.end(), chunk, chunk + read);
+    }
+    std::fclose(file);
+
+    if (_data.size() < kTraceHeaderLength || std::memcmp(_data.data(), kTraceMagic, sizeof(kTraceMagic)) != 0)
+    {
+        return false;
+    }
+    ByteReader reader(_data.data() + sizeof(kTraceMagic), 4);
+    _version = reader.getUInt16();
+    if (_version < kOldestReadableTraceVersion || _version > kTraceVersion)
+    {
+        return false;
+    }
+    _offset = kTraceHeaderLength;
+    return true;
+}
+
+bool TraceReader::next(TraceRecord &record)
+{
+    while (_offset < _data.size())
+    {
+        ByteReader reader(_data.data() + _offset, _data.size() - _offset);
+        uint8_t tag = reader.getUInt8();
+        int64_t microseconds = _lastMicroseconds;
+        bool produced = false;
+
+        switch (tag)
+        {
+            case RecordTagLocation:
+            {
+                std::string encoded = reader.getString();
+                record.type = TraceRecordType::Location;
+                record.location = reader.failed() ? nullptr : decodeLocation(encoded);
+                produced = record.location != nullptr;
+                if (!produced)
+                {
+                    _truncated = true;
+                    return false;
+                }
+                _locations.push_back(record.location);
+                break;
+            }
+            case RecordTagLocationStop:
+            {
+                uint64_t index = reader.getVarUInt();
+                if (!reader.failed() && index >= _locations.size())
+                {
+                    _truncated = true;
+                    return false;
+                }
+                record.type = TraceRecordType::LocationStop;
+                record.location = reader.failed() ? nullptr : _locations[static_cast<size_t>(index)];
+                produced = true;
+                break;
+            }
+            case RecordTagBeaconDefinition:
+            {
+                BeaconId beacon = reader.getUInt64();
+                std::string identifier = _version >= 2 ? reader.getString() : std::string();
+                if (!reader.failed())
+                {
+                    _beacons.push_back(beacon);
+                    if (!identifier.empty())
+                    {
+                        _beaconIdentifiers[beacon] = std::move(identifier);
+                    }
+                }
+                break;
+            }
+            case RecordTagBeaconSample:
+            {
+                microseconds += reader.getVarInt();
+                uint64_t index = reader.getVarUInt();
+                int8_t rssi = static_cast<int8_t>(reader.getUInt8());
+                if (!reader.failed() && index >= _beacons.size())
+                {
+                    _truncated = true;
+                    return false;
+                }
+                record.type = TraceRecordType::BeaconSample;
+                record.beaconSample.beacon = reader.failed() ? 0 : _beacons[static_cast<size_t>(index)];
+                record.beaconSample.timestamp = microseconds / 1e6;
+                record.beaconSample.rssi = rssi;
+                produced = true;
+                break;
+            }
+            case RecordTagSensorSample:
+            {
+                microseconds += reader.getVarInt();
+                record.type = TraceRecordType::SensorSample;
+                record.sensorSample.timestamp = microseconds / 1e6;
+                record.sensorSample.type = static_cast<SensorType>(reader.getUInt8());
+                record.sensorSample.x = reader.getFloat();
+                record.sensorSample.y = reader.getFloat();
+                record.sensorSample.z = reader.getFloat();
+                produced = true;
+                break;
+            }
+            default:
+                _truncated = true;
+                return false;
+        }
+
+        if (reader.failed())
+        {
+            _truncated = true;
+            return false;
+        }
+        _offset += reader.offset();
+        _lastMicroseconds = microseconds;
+        if (produced)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::string &TraceReader::beaconIdentifier(BeaconId beacon) const
+{
+    static const std::string unknown;
+    auto identifier = _beaconIdentifiers.find(beacon);
+    return identifier != _beaconIdentifiers.end() ? identifier->second : unknown;
+}
+
+} // namespace eil
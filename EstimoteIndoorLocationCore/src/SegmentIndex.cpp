@@ -0,0 +1,347 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/SegmentIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eil {
+
+namespace {
+
+/** Leaves hold at most this many segments. */
+constexpr uint32_t kMaximumLeafSize = 4;
+
+/** Deepest possible tree for 2^32 segments split in halves, with room to spare. */
+constexpr size_t kMaximumDepth = 64;
+
+/** Marks that no segment was found yet. */
+constexpr uint32_t kNoSegment = UINT32_MAX;
+
+/**
+ * Relative slack when comparing box distances with segment distances. Both are computed with different roundings,
+ * and a box must never be skipped because its distance came out a few units in the last place too large.
+ */
+constexpr double kPruningSlack = 1.0 + 1e-12;
+
+double boxDistanceSquared(const Rect &box, const Point &point)
+{
+    double dX = std::max(std::max(box.minX - point.x, point.x - box.maxX), 0.0);
+    double dY = std::max(std::max(box.minY - point.y, point.y - box.maxY), 0.0);
+    return dX * dX + dY * dY;
+}
+
+Rect boxOfSegment(const Point &a, const Point &b)
+{
+    Rect box;
+    box.minX = std::min(a.x, b.x);
+    box.minY = std::min(a.y, b.y);
+    box.maxX = std::max(a.x, b.x);
+    box.maxY = std::max(a.y, b.y);
+    return box;
+}
+
+/** Orientation of the triangle (a, b, c): positive if counter clockwise, negative if clockwise, zero if collinear. */
+double cross(const Point &a, const Point &b, const Point &c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/** Whether a point collinear with a segment lies within its bounding box, i.e. on the segment. */
+bool onSegment(const Point &a, const Point &b, const Point &point)
+{
+    return std::min(a.x, b.x) <= point.x && point.x <= std::max(a.x, b.x) && std::min(a.y, b.y) <= point.y
+           && point.y <= std::max(a.y, b.y);
+}
+
+bool segmentsIntersect(const Point &a, const Point &b, const Point &c, const Point &d)
+{
+    double abc = cross(a, b, c);
+    double abd = cross(a, b, d);
+    double cda = cross(c, d, a);
+    double cdb = cross(c, d, b);
+    if (((abc > 0.0 && abd < 0.0) || (abc < 0.0 && abd > 0.0)) && ((cda > 0.0 && cdb < 0.0) || (cda < 0.0 && cdb > 0.0)))
+    {
+        return true;
+    }
+    return (abc == 0.0 && onSegment(a, b, c)) || (abd == 0.0 && onSegment(a, b, d)) || (cda == 0.0 && onSegment(c, d, a))
+           || (cdb == 0.0 && onSegment(c, d, b));
+}
+
+/** Whether a line segment may cross a box: their bounding boxes overlap and the box is not entirely on one side. */
+bool segmentMayCrossBox(const Point &a, const Point &b, const Rect &segmentBox, const Rect &box)
+{
+    if (segmentBox.maxX < box.minX || segmentBox.minX > box.maxX || segmentBox.maxY < box.minY
+        || segmentBox.minY > box.maxY)
+    {
+        return false;
+    }
+    double c1 = cross(a, b, Point(box.minX, box.minY));
+    double c2 = cross(a, b, Point(box.maxX, box.minY));
+    double c3 = cross(a, b, Point(box.minX, box.maxY));
+    double c4 = cross(a, b, Point(box.maxX, box.maxY));
+    return !((c1 > 0.0 && c2 > 0.0 && c3 > 0.0 && c4 > 0.0) || (c1 < 0.0 && c2 < 0.0 && c3 < 0.0 && c4 < 0.0));
+}
+
+} // namespace
+
+SegmentIndex::SegmentIndex(const Location &location)
+{
+    std::vector<Segment> segments;
+    auto addSegment = [&segments](const OrientedLineSegment &line, unsigned kind, size_t index) {
+        Point direction(line.point2.x - line.point1.x, line.point2.y - line.point1.y);
+        double lengthSquared = direction.x * direction.x + direction.y * direction.y;
+        segments.push_back(Segment{line.point1, direction, lengthSquared > 0.0 ? 1.0 / lengthSquared : 0.0, kind,
+                                   static_cast<uint32_t>(index)});
+    };
+    const std::vector<OrientedLineSegment> &walls = location.boundarySegments();
+    for (size_t i = 0; i < walls.size(); i++)
+    {
+        addSegment(walls[i], kWallSegments, i);
+    }
+    const std::vector<LinearObject> &linearObjects = location.linearObjects();
+    for (size_t i = 0; i < linearObjects.size(); i++)
+    {
+        addSegment(linearObjects[i].position,
+                   linearObjects[i].type == LinearObjectType::Door ? kDoorSegments : kWindowSegments, i);
+    }
+    if (segments.empty())
+    {
+        return;
+    }
+
+    std::vector<Point> centers;
+    std::vector<uint32_t> order(segments.size());
+    centers.reserve(segments.size());
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        const Segment &segment = segments[i];
+        centers.push_back(Point(segment.origin.x + segment.direction.x / 2.0,
+                                segment.origin.y + segment.direction.y / 2.0));
+        order[i] = static_cast<uint32_t>(i);
+    }
+
+    // A binary tree with leaves of up to `kMaximumLeafSize` segments has fewer than 2 * count nodes.
+    _nodes.reserve(2 * segments.size());
+    _nodes.push_back(Node());
+    build(segments, centers, order, 0, 0, static_cast<uint32_t>(segments.size()));
+
+    // Leaves refer to ranges of `order`; storing segments in that order keeps every leaf contiguous.
+    _segments.reserve(segments.size());
+    for (uint32_t index : order)
+    {
+        _segments.push_back(segments[index]);
+    }
+}
+
+void SegmentIndex::build(const std::vector<Segment> &segments, const std::vector<Point> &centers,
+                         std::vector<uint32_t> &order, uint32_t node, uint32_t begin, uint32_t end)
+{
+    Rect box;
+    Rect centerBox;
+    unsigned kinds = 0;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        const Segment &segment = segments[order[i]];
+        Rect segmentBox = boxOfSegment(segment.origin, Point(segment.origin.x + segment.direction.x,
+                                                             segment.origin.y + segment.direction.y));
+        const Point &center = centers[order[i]];
+        if (i == begin)
+        {
+            box = segmentBox;
+            centerBox = Rect{center.x, center.y, center.x, center.y};
+        }
+        box.minX = std::min(box.minX, segmentBox.minX);
+        box.minY = std::min(box.minY, segmentBox.minY);
+        box.maxX = std::max(box.maxX, segmentBox.maxX);
+        box.maxY = std::max(box.maxY, segmentBox.maxY);
+        centerBox.minX = std::min(centerBox.minX, center.x);
+        centerBox.minY = std::min(centerBox.minY, center.y);
+        centerBox.maxX = std::max(centerBox.maxX, center.x);
+        centerBox.maxY = std::max(centerBox.maxY, center.y);
+        kinds |= segment.kind;
+    }
+    _nodes[node].box = box;
+    _nodes[node].kinds = kinds;
+
+    if (end - begin <= kMaximumLeafSize)
+    {
+        _nodes[node].first = begin;
+        _nodes[node].count = end - begin;
+        return;
+    }
+
+    // Median split along the longer side of the box of the centers keeps the tree balanced.
+    bool splitX = centerBox.width() >= centerBox.height();
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                     [&centers, splitX](uint32_t a, uint32_t b) {
+                         return splitX ? centers[a].x < centers[b].x : centers[a].y < centers[b].y;
+                     });
+
+    uint32_t firstChild = static_cast<uint32_t>(_nodes.size());
+    _nodes.push_back(Node());
+    _nodes.push_back(Node());
+    _nodes[node].first = firstChild;
+    _nodes[node].count = 0;
+    build(segments, centers, order, firstChild, begin, middle);
+    build(segments, centers, order, firstChild + 1, middle, end);
+}
+
+SegmentHit SegmentIndex::nearestSegment(const Point &point, unsigned kinds) const
+{
+    uint32_t best = kNoSegment;
+    search(point, kinds, best);
+    return makeHit(point, best);
+}
+
+void SegmentIndex::nearestSegments(const Point *points, size_t count, SegmentHit *hits, unsigned kinds) const
+{
+    uint32_t best = kNoSegment;
+    for (size_t i = 0; i < count; i++)
+    {
+        search(points[i], kinds, best);
+        hits[i] = makeHit(points[i], best);
+    }
+}
+
+void SegmentIndex::distancesToNearest(const Point *points, size_t count, double *distances, unsigned kinds) const
+{
+    uint32_t best = kNoSegment;
+    for (size_t i = 0; i < count; i++)
+    {
+        distances[i] = std::sqrt(search(points[i], kinds, best));
+    }
+}
+
+double SegmentIndex::search(const Point &point, unsigned kinds, uint32_t &best) const
+{
+    double bestSquared = std::numeric_limits<double>::infinity();
+    if (best != kNoSegment)
+    {
+        Point closest;
+        bestSquared = distanceSquared(_segments[best], point, closest);
+    }
+    if (_nodes.empty() || !(_nodes[0].kinds & kinds))
+    {
+        return bestSquared;
+    }
+
+    uint32_t stack[kMaximumDepth];
+    size_t depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0)
+    {
+        const Node &node = _nodes[stack[--depth]];
+        // Boxes exactly as far as the best segment may still hold a tie that comes first in the tree.
+        if (boxDistanceSquared(node.box, point) > bestSquared * kPruningSlack)
+        {
+            continue;
+        }
+
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                const Segment &segment = _segments[i];
+                if (!(segment.kind & kinds))
+                {
+                    continue;
+                }
+                Point closest;
+                double squared = distanceSquared(segment, point, closest);
+                if (squared < bestSquared || (squared == bestSquared && i < best))
+                {
+                    bestSquared = squared;
+                    best = i;
+                }
+            }
+            continue;
+        }
+
+        // The nearer child goes on top of the stack, so it is searched first and tightens the bound for the other.
+        uint32_t near = node.first;
+        uint32_t far = node.first + 1;
+        double nearSquared = boxDistanceSquared(_nodes[near].box, point);
+        double farSquared = boxDistanceSquared(_nodes[far].box, point);
+        if (farSquared < nearSquared)
+        {
+            std::swap(near, far);
+            std::swap(nearSquared, farSquared);
+        }
+        if ((_nodes[far].kinds & kinds) && farSquared <= bestSquared * kPruningSlack)
+        {
+            stack[depth++] = far;
+        }
+        if ((_nodes[near].kinds & kinds) && nearSquared <= bestSquared * kPruningSlack)
+        {
+            stack[depth++] = near;
+        }
+    }
+    return bestSquared;
+}
+
+bool SegmentIndex::intersects(const Point &a, const Point &b, unsigned kinds) const
+{
+    if (_nodes.empty())
+    {
+        return false;
+    }
+
+    Rect segmentBox = boxOfSegment(a, b);
+    uint32_t stack[kMaximumDepth];
+    size_t depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0)
+    {
+        const Node &node = _nodes[stack[--depth]];
+        if (!(node.kinds & kinds) || !segmentMayCrossBox(a, b, segmentBox, node.box))
+        {
+            continue;
+        }
+        if (node.count == 0)
+        {
+            stack[depth++] = node.first;
+            stack[depth++] = node.first + 1;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            const Segment &segment = _segments[i];
+            Point end(segment.origin.x + segment.direction.x, segment.origin.y + segment.direction.y);
+            if ((segment.kind & kinds) && segmentsIntersect(a, b, segment.origin, end))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+SegmentHit SegmentIndex::makeHit(const Point &point, uint32_t best) const
+{
+    SegmentHit hit;
+    if (best == kNoSegment)
+    {
+        return hit;
+    }
+    const Segment &segment = _segments[best];
+    double squared = distanceSquared(segment, point, hit.closestPoint);
+    hit.kind = segment.kind;
+    hit.index = segment.index;
+    hit.distance = std::sqrt(squared);
+    return hit;
+}
+
+double SegmentIndex::distanceSquared(const Segment &segment, const Point &point, Point &closest)
+{
+    double t = ((point.x - segment.origin.x) * segment.direction.x + (point.y - segment.origin.y) * segment.direction.y)
+               * segment.inverseLengthSquared;
+    t = std::max(0.0, std::min(1.0, t));
+    closest = Point(segment.origin.x + t * segment.direction.x, segment.origin.y + t * segment.direction.y);
+    double dX = point.x - closest.x;
+    double dY = point.y - closest.y;
+    return dX * dX + dY * dY;
+}
+
+} // namespace eil
@@ -0,0 +1,283 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/SignalMap.hpp"
+
+#include "BinaryCoding.hpp"
+#include "EILCore/LocationCoding.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace eil {
+
+namespace {
+
+const char kSignalMapMagic[8] = {'E', 'I', 'L', 'S', 'I', 'G', 'M', 'P'};
+constexpr uint16_t kSignalMapVersion = 1;
+constexpr size_t kSignalMapHeaderLength = sizeof(kSignalMapMagic) + 4 + 8 + 5 * 8 + 3 * 4;
+
+/** Maps larger than this are not built; the venue should use a coarser grid. */
+constexpr uint64_t kMaximumSignalMapLength = 512ULL * 1024 * 1024;
+
+/** Distances below this value are clamped, matching the signal model of `ParticleFilter`. */
+constexpr double kMinimumDistanceSquared = 0.25;
+
+/** Hash of the parameters a map is computed with, for the file name. */
+uint32_t parametersHash(const AlgorithmParameters &parameters)
+{
+    std::string bytes;
+    ByteWriter writer(bytes);
+    writer.putDouble(parameters.measuredPower);
+    writer.putDouble(parameters.pathLossExponent);
+    writer.putDouble(parameters.signalMapCellSize);
+
+    // 64-bit FNV-1a, folded to 32 bits.
+    uint64_t hash = 14695981039346656037ULL;
+    for (char byte : bytes)
+    {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+uint8_t quantizeRssi(double rssi)
+{
+    double steps = std::round(-rssi * 2.0);
+    return static_cast<uint8_t>(std::min(255.0, std::max(0.0, steps)));
+}
+
+} // namespace
+
+SignalMap::~SignalMap()
+{
+    if (_mapping != nullptr)
+    {
+        munmap(_mapping, _mappingLength);
+    }
+}
+
+SignalMapRef SignalMap::build(const Location &location, const AlgorithmParameters &parameters)
+{
+    double cellSize = parameters.signalMapCellSize;
+    const Rect &box = location.boundingBox();
+    if (!(cellSize > 0.0) || location.beacons().empty())
+    {
+        return nullptr;
+    }
+    uint64_t columns = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(box.width() / cellSize)));
+    uint64_t rows = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(box.height() / cellSize)));
+    uint64_t beaconCount = location.beacons().size();
+    if (columns * rows * beaconCount > kMaximumSignalMapLength)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<SignalMap> map(new SignalMap());
+    map->_fingerprint = locationFingerprint(location);
+    map->_measuredPower = parameters.measuredPower;
+    map->_pathLossExponent = parameters.pathLossExponent;
+    map->_cellSize = cellSize;
+    map->_inverseCellSize = 1.0 / cellSize;
+    map->_originX = box.minX;
+    map->_originY = box.minY;
+    map->_columns = static_cast<size_t>(columns);
+    map->_rows = static_cast<size_t>(rows);
+    map->_beaconCount = static_cast<size_t>(beaconCount);
+
+    double pathLossFactor = 5.0 * parameters.pathLossExponent;
+    const std::vector<PositionedBeacon> &beacons = location.beacons();
+    map->_ownedData.resize(map->_columns * map->_rows * map->_beaconCount);
+    uint8_t *cell = map->_ownedData.data();
+    for (size_t r = 0; r < map->_rows; r++)
+    {
+        double y = box.minY + (r + 0.5) * cellSize;
+        for (size_t c = 0; c < map->_columns; c++)
+        {
+            double x = box.minX + (c + 0.5) * cellSize;
+            for (const PositionedBeacon &beacon : beacons)
+            {
+                double dX = x - beacon.position.x;
+                double dY = y - beacon.position.y;
+                double distanceSquared = std::max(kMinimumDistanceSquared, dX * dX + dY * dY);
+                *cell++ = quantizeRssi(parameters.measuredPower - pathLossFactor * std::log10(distanceSquared));
+            }
+        }
+    }
+    map->_data = map->_ownedData.data();
+    return map;
+}
+
+SignalMapRef SignalMap::load(const std::string &path, const Location &location, const AlgorithmParameters &parameters)
+{
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return nullptr;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size < static_cast<off_t>(kSignalMapHeaderLength))
+    {
+        ::close(descriptor);
+        return nullptr;
+    }
+    size_t length = static_cast<size_t>(status.st_size);
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping stays valid after the descriptor is closed.
+    ::close(descriptor);
+    if (mapping == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<SignalMap> map(new SignalMap());
+    map->_mapping = mapping;
+    map->_mappingLength = length;
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(mapping);
+    if (std::memcmp(bytes, kSignalMapMagic, sizeof(kSignalMapMagic)) != 0)
+    {
+        return nullptr;
+    }
+    ByteReader reader(bytes + sizeof(kSignalMapMagic), kSignalMapHeaderLength - sizeof(kSignalMapMagic));
+    if (reader.getUInt16() != kSignalMapVersion)
+    {
+        return nullptr;
+    }
+    reader.getUInt16();
+    map->_fingerprint = reader.getUInt64();
+    map->_measuredPower = reader.getDouble();
+    map->_pathLossExponent = reader.getDouble();
+    map->_cellSize = reader.getDouble();
+    map->_originX = reader.getDouble();
+    map->_originY = reader.getDouble();
+    uint64_t columns = reader.getUInt32();
+    uint64_t rows = reader.getUInt32();
+    uint64_t beaconCount = reader.getUInt32();
+    if (reader.failed() || columns == 0 || rows == 0 || !(map->_cellSize > 0.0)
+        || columns * rows * beaconCount != length - kSignalMapHeaderLength)
+    {
+        return nullptr;
+    }
+    map->_inverseCellSize = 1.0 / map->_cellSize;
+    map->_columns = static_cast<size_t>(columns);
+    map->_rows = static_cast<size_t>(rows);
+    map->_beaconCount = static_cast<size_t>(beaconCount);
+    map->_data = bytes + kSignalMapHeaderLength;
+
+    if (!map->matches(location, parameters))
+    {
+        return nullptr;
+    }
+    return map;
+}
+
+bool SignalMap::save(const std::string &path) const
+{
+    std::string header(kSignalMapMagic, sizeof(kSignalMapMagic));
+    ByteWriter writer(header);
+    writer.putUInt16(kSignalMapVersion);
+    writer.putUInt16(0);
+    writer.putUInt64(_fingerprint);
+    writer.putDouble(_measuredPower);
+    writer.putDouble(_pathLossExponent);
+    writer.putDouble(_cellSize);
+    writer.putDouble(_originX);
+    writer.putDouble(_originY);
+    writer.putUInt32(static_cast<uint32_t>(_columns));
+    writer.putUInt32(static_cast<uint32_t>(_rows));
+    writer.putUInt32(static_cast<uint32_t>(_beaconCount));
+
+    // Written next to the target and renamed over it, so a concurrent reader never maps a partially written file.
+    std::string temporaryPath = path + ".tmp";
+    FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    size_t dataLength = _columns * _rows * _beaconCount;
+    bool written = std::fwrite(header.data(), 1, header.size(), file) == header.size()
+                   && std::fwrite(_data, 1, dataLength, file) == dataLength;
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SignalMap::matches(const Location &location, const AlgorithmParameters &parameters) const
+{
+    return _measuredPower == parameters.measuredPower
+           && _pathLossExponent == parameters.pathLossExponent
+           && _cellSize == parameters.signalMapCellSize
+           && _beaconCount == location.beacons().size()
+           && _fingerprint == locationFingerprint(location);
+}
+
+SignalMapCache::SignalMapCache(std::string directory)
+    : _directory(std::move(directory))
+{
+}
+
+std::string SignalMapCache::pathForLocation(const Location &location, const AlgorithmParameters &parameters) const
+{
+    // Identifiers come from the cloud; anything but a conservative set of characters is replaced to keep the name valid.
+    std::string name;
+    for (char character : location.identifier())
+    {
+        bool safe = (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z')
+                    || (character >= '0' && character <= '9') || character == '-' || character == '_';
+        name.push_back(safe ? character : '_');
+    }
+    if (name.empty())
+    {
+        name = "location";
+    }
+
+    char key[26];
+    std::snprintf(key, sizeof(key), "%016llx-%08lx", static_cast<unsigned long long>(locationFingerprint(location)),
+                  static_cast<unsigned long>(parametersHash(parameters)));
+    std::string path = _directory;
+    if (!path.empty() && path.back() != '/')
+    {
+        path.push_back('/');
+    }
+    return path + name + "-" + key + ".eilmap";
+}
+
+SignalMapRef SignalMapCache::signalMapForLocation(const Location &location, const AlgorithmParameters &parameters)
+{
+    std::string path = pathForLocation(location, parameters);
+    SignalMapRef map = _maps[path].lock();
+    if (map && map->matches(location, parameters))
+    {
+        return map;
+    }
+
+    map = SignalMap::load(path, location, parameters);
+    if (!map)
+    {
+        map = SignalMap::build(location, parameters);
+        if (map && map->save(path))
+        {
+            // Served from the file from now on, so the memory of the computed copy can be given back.
+            SignalMapRef mapped = SignalMap::load(path, location, parameters);
+            if (mapped)
+            {
+                map = mapped;
+            }
+        }
+    }
+    _maps[path] = map;
+    return map;
+}
+
+} // namespace eil
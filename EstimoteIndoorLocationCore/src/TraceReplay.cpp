@@ -0,0 +1,128 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/TraceReplay.hpp"
+
+#include "EILCore/InertialFusion.hpp"
+#include "EILCore/ScanTrace.hpp"
+
+#include <chrono>
+#include <ctime>
+
+namespace eil {
+
+namespace {
+
+/** Accumulates wall clock and processor time of the enclosed scope. */
+class ScopedTimer
+{
+public:
+    ScopedTimer(double &wallTime, double &cpuTime)
+        : _wallTime(wallTime), _cpuTime(cpuTime),
+          _wallStart(std::chrono::steady_clock::now()), _cpuStart(std::clock())
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        _cpuTime += static_cast<double>(std::clock() - _cpuStart) / CLOCKS_PER_SEC;
+        _wallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - _wallStart).count();
+    }
+
+private:
+    double &_wallTime;
+    double &_cpuTime;
+    std::chrono::steady_clock::time_point _wallStart;
+    std::clock_t _cpuStart;
+};
+
+} // namespace
+
+bool TraceReplayer::replay(const std::string &path, LocationRef location)
+{
+    _statistics = TraceReplayStatistics();
+
+    TraceReader reader;
+    if (!reader.open(path))
+    {
+        return false;
+    }
+
+    PositioningEngine engine(_parameters);
+    engine.setSignalMapCache(_signalMapCache);
+    engine.setPositionHandler([this](const PositionUpdate &update, const Location &updatedLocation) {
+        _statistics.positionUpdates++;
+        if (_positionHandler)
+        {
+            _positionHandler(update, updatedLocation);
+        }
+    });
+    bool hasLocation = location != nullptr;
+    if (hasLocation)
+    {
+        engine.startPositionUpdates(location);
+    }
+
+    bool hasTimestamp = false;
+    double firstTimestamp = 0.0;
+    double lastTimestamp = 0.0;
+    TraceRecord record;
+    while (reader.next(record))
+    {
+        if (record.type == TraceRecordType::Location)
+        {
+            // Locations are started and stopped as during the recording, several of them positioned in simultaneously.
+            if (!location)
+            {
+                engine.startPositionUpdates(record.location);
+                hasLocation = true;
+            }
+            continue;
+        }
+        if (record.type == TraceRecordType::LocationStop)
+        {
+            if (!location)
+            {
+                engine.stopPositionUpdates(*record.location);
+            }
+            continue;
+        }
+        if (!hasLocation)
+        {
+            continue;
+        }
+
+        double timestamp = record.type == TraceRecordType::BeaconSample ? record.beaconSample.timestamp : record.sensorSample.timestamp;
+        if (!hasTimestamp)
+        {
+            hasTimestamp = true;
+            firstTimestamp = timestamp;
+        }
+        lastTimestamp = timestamp;
+
+        if (record.type == TraceRecordType::BeaconSample)
+        {
+            _statistics.beaconSamples++;
+            ScopedTimer timer(_statistics.wallTime, _statistics.cpuTime);
+            engine.processSample(record.beaconSample);
+        }
+        else
+        {
+            // Sensor samples mean the trace was recorded in the inertial positioning mode. The fusion runs on this
+            // thread, one sample at a time, so the motion the engine reads is the one at the time of the trace.
+            if (!engine.inertialFusion())
+            {
+                engine.setInertialFusion(std::make_shared<InertialFusion>(1, _inertialStepLength, false));
+            }
+            _statistics.sensorSamples++;
+            ScopedTimer timer(_statistics.wallTime, _statistics.cpuTime);
+            engine.processSensorSample(record.sensorSample);
+            engine.inertialFusion()->processPendingSamples();
+        }
+    }
+
+    _statistics.traceDuration = lastTimestamp - firstTimestamp;
+    _statistics.truncated = reader.isTruncated();
+    return hasLocation;
+}
+
+} // namespace eil
@@ -0,0 +1,67 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+#include "EILCore/TransformedLocation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace eil {
+
+TransformedLocation::TransformedLocation(LocationRef location, const RigidTransform &transform)
+    : _location(std::move(location)), _transform(transform), _inverse(transform.inverse())
+{
+}
+
+TransformedLocation TransformedLocation::transformedBy(const RigidTransform &transform) const
+{
+    return TransformedLocation(_location, _transform.followedBy(transform));
+}
+
+double TransformedLocation::orientation() const
+{
+    if (_transform.isTranslation())
+    {
+        return _location->orientation();
+    }
+    double orientation = std::fmod(_location->orientation() - _transform.angle(), 360.0);
+    return orientation < 0.0 ? orientation + 360.0 : orientation;
+}
+
+Rect TransformedLocation::boundingBox() const
+{
+    const std::vector<Point> &polygon = _location->polygon();
+    if (_transform.isTranslation() || polygon.empty())
+    {
+        Rect box = _location->boundingBox();
+        box.minX += _transform.dX();
+        box.maxX += _transform.dX();
+        box.minY += _transform.dY();
+        box.maxY += _transform.dY();
+        return box;
+    }
+
+    Rect box;
+    Point first = fromBase(polygon[0]);
+    box.minX = box.maxX = first.x;
+    box.minY = box.maxY = first.y;
+    for (const Point &vertex : polygon)
+    {
+        Point point = fromBase(vertex);
+        box.minX = std::min(box.minX, point.x);
+        box.minY = std::min(box.minY, point.y);
+        box.maxX = std::max(box.maxX, point.x);
+        box.maxY = std::max(box.maxY, point.y);
+    }
+    return box;
+}
+
+void TransformedLocation::randomPointsInside(Random &random, Point *points, size_t count) const
+{
+    _location->randomPointsInside(random, points, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        points[i] = fromBase(points[i]);
+    }
+}
+
+} // namespace eil
@@ -0,0 +1,815 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+// Benchmarks the positioning engine on synthetic venues, from a 10 m² room up to a 10,000 m² hall.
+//
+// Usage: eil-bench [--duration <seconds>] [--seed <seed>] [--area <m²>] [--csv]
+//        eil-bench --verify-indexes [--seed <seed>]
+//        eil-bench --routing [--seed <seed>]
+//
+// Each venue is built with LocationBuilder: beacons along the walls and, in larger venues, on a grid across the floor.
+// A user walks a scripted route through the venue while beacons advertise with log-distance path loss, Gaussian noise,
+// packet loss and a receiver sensitivity limit. Results are printed as a table, or as CSV with --csv.
+//
+// The seed drives both the synthesized signal and the filter, so position errors are identical between runs and only
+// timings vary.
+//
+// With --verify-indexes the acceleration structures of the core are checked against brute force instead: every query
+// has to give exactly the same answer. The exit status is 1 if any answer differs.
+//
+// With --routing the time to build a navigation graph and its pin distance fields is measured on an office floor, and
+// the time to answer a route or distance from a random point, by the fields and by A*. The exit status is 1 if a field
+// and A* disagree on a length.
+
+#include "EILCore/EILCore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace {
+
+/** Distance between neighboring beacons, in meters. */
+constexpr double kBeaconSpacing = 8.0;
+/** Interval between advertisements of a single beacon, in seconds. */
+constexpr double kAdvertisingInterval = 0.2;
+/** Fraction of advertisements that are not received. */
+constexpr double kPacketLoss = 0.2;
+/** Advertisements weaker than this are not received, in dBm. */
+constexpr double kReceiverSensitivity = -100.0;
+/** Walking speed of the user, in meters per second. */
+constexpr double kWalkingSpeed = 1.2;
+
+constexpr double kPi = 3.14159265358979323846;
+
+struct Venue
+{
+    double area;
+    eil::LocationRef location;
+};
+
+struct Result
+{
+    double area = 0.0;
+    size_t beaconCount = 0;
+    size_t samples = 0;
+    size_t updates = 0;
+    double cpuTime = 0.0;
+    double wallTime = 0.0;
+    double meanError = 0.0;
+    double p90Error = 0.0;
+    long peakResidentKilobytes = 0;
+};
+
+/** Builds a rectangular venue with a 3:2 aspect ratio. */
+Venue buildVenue(double area)
+{
+    double width = std::sqrt(area * 1.5);
+    double height = area / width;
+
+    eil::LocationBuilder builder;
+    builder.setLocationBoundaryPoints({{0.0, 0.0}, {0.0, height}, {width, height}, {width, 0.0}});
+    builder.setLocationName("Synthetic " + std::to_string(static_cast<int>(area)) + " m²");
+    builder.setLocationIdentifier("synthetic-" + std::to_string(static_cast<int>(area)));
+
+    int beaconIndex = 0;
+    double lengths[] = {height, width, height, width};
+    for (size_t segment = 0; segment < 4; segment++)
+    {
+        int count = std::max(1, static_cast<int>(lengths[segment] / kBeaconSpacing));
+        for (int i = 0; i < count; i++)
+        {
+            double distance = (i + 0.5) * lengths[segment] / count;
+            builder.addBeacon("bench" + std::to_string(beaconIndex++), segment, distance, eil::LocationBuilderSide::Left);
+        }
+    }
+    // Walls alone do not cover large halls, the floor gets a grid of ceiling-mounted beacons.
+    for (double x = kBeaconSpacing; x < width - kBeaconSpacing / 2.0; x += kBeaconSpacing)
+    {
+        for (double y = kBeaconSpacing; y < height - kBeaconSpacing / 2.0; y += kBeaconSpacing)
+        {
+            builder.addBeacon("bench" + std::to_string(beaconIndex++), eil::OrientedPoint(x, y));
+        }
+    }
+    return {area, builder.build()};
+}
+
+/** Scripted walk: a lawnmower route through the venue, one meter away from the walls. */
+class Walk
+{
+public:
+    explicit Walk(const eil::Location &location)
+    {
+        const eil::Rect &box = location.boundingBox();
+        double inset = std::min(1.0, std::min(box.width(), box.height()) / 4.0);
+        double lanes = std::max(1.0, std::floor((box.height() - 2.0 * inset) / 4.0));
+        double laneSpacing = (box.height() - 2.0 * inset) / lanes;
+        for (int lane = 0; lane <= static_cast<int>(lanes); lane++)
+        {
+            double y = box.minY + inset + lane * laneSpacing;
+            bool leftToRight = lane % 2 == 0;
+            _waypoints.emplace_back(leftToRight ? box.minX + inset : box.maxX - inset, y);
+            _waypoints.emplace_back(leftToRight ? box.maxX - inset : box.minX + inset, y);
+        }
+        _cumulative.push_back(0.0);
+        for (size_t i = 1; i < _waypoints.size(); i++)
+        {
+            _cumulative.push_back(_cumulative.back() + _waypoints[i].distanceTo(_waypoints[i - 1]));
+        }
+    }
+
+    /** Position at the given time. The route is walked back and forth. */
+    eil::Point positionAt(double time) const
+    {
+        double total = _cumulative.back();
+        if (total <= 0.0)
+        {
+            return _waypoints.front();
+        }
+        double distance = std::fmod(time * kWalkingSpeed, 2.0 * total);
+        if (distance > total)
+        {
+            distance = 2.0 * total - distance;
+        }
+        size_t segment = std::upper_bound(_cumulative.begin(), _cumulative.end(), distance) - _cumulative.begin();
+        segment = std::min(std::max<size_t>(segment, 1), _waypoints.size() - 1);
+        const eil::Point &from = _waypoints[segment - 1];
+        const eil::Point &to = _waypoints[segment];
+        double length = _cumulative[segment] - _cumulative[segment - 1];
+        double fraction = length > 0.0 ? (distance - _cumulative[segment - 1]) / length : 0.0;
+        return eil::Point(from.x + (to.x - from.x) * fraction, from.y + (to.y - from.y) * fraction);
+    }
+
+private:
+    std::vector<eil::Point> _waypoints;
+    std::vector<double> _cumulative;
+};
+
+/** Even-odd test over all edges, visited in the order `PolygonIndex` visits them; the reference the index has to match. */
+bool containsPointNaively(const std::vector<eil::Point> &polygon, double x, double y)
+{
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+    {
+        const eil::Point &a = polygon[i];
+        const eil::Point &b = polygon[j];
+        if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x)
+        {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+/** Concave star of 200 vertices with jittered radii. */
+std::vector<eil::Point> starPolygon(eil::Random &random)
+{
+    std::vector<eil::Point> polygon;
+    for (int i = 0; i < 200; i++)
+    {
+        double angle = 2.0 * kPi * i / 200.0;
+        double radius = (i % 2 == 0 ? 50.0 : 20.0) + random.uniform(0.0, 5.0);
+        polygon.emplace_back(60.0 + radius * std::cos(angle), 60.0 + radius * std::sin(angle));
+    }
+    return polygon;
+}
+
+/** Comb of 50 teeth with axis-aligned edges on integer coordinates, 202 vertices. */
+std::vector<eil::Point> combPolygon()
+{
+    std::vector<eil::Point> polygon = {{0.0, 0.0}, {100.0, 0.0}};
+    for (int tooth = 49; tooth >= 0; tooth--)
+    {
+        double x = 2.0 * tooth;
+        polygon.insert(polygon.end(), {{x + 2.0, 40.0}, {x + 1.0, 40.0}, {x + 1.0, 10.0}, {x, 10.0}});
+    }
+    return polygon;
+}
+
+/**
+ * Compares `PolygonIndex::containsPoint` and `containsPoints` with the plain test on random points, on points on and
+ * next to edges, at vertices, on horizontal rays through vertices and on a half-meter lattice.
+ *
+ * @return Number of points with a different answer.
+ */
+size_t verifyPolygonIndex(const std::vector<eil::Point> &polygon, eil::Random &random, size_t &pointCount)
+{
+    eil::PolygonIndex index(polygon);
+    eil::Rect box;
+    box.minX = box.maxX = polygon[0].x;
+    box.minY = box.maxY = polygon[0].y;
+    for (const eil::Point &vertex : polygon)
+    {
+        box.minX = std::min(box.minX, vertex.x);
+        box.minY = std::min(box.minY, vertex.y);
+        box.maxX = std::max(box.maxX, vertex.x);
+        box.maxY = std::max(box.maxY, vertex.y);
+    }
+
+    std::vector<eil::Point> points;
+    for (int i = 0; i < 200000; i++)
+    {
+        points.emplace_back(random.uniform(box.minX - 1.0, box.maxX + 1.0), random.uniform(box.minY - 1.0, box.maxY + 1.0));
+    }
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+    {
+        const eil::Point &a = polygon[i];
+        const eil::Point &b = polygon[j];
+        points.push_back(a);
+        points.emplace_back(random.uniform(box.minX - 1.0, box.maxX + 1.0), a.y);
+        for (int k = 0; k < 100; k++)
+        {
+            double t = random.uniform();
+            eil::Point onEdge(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t);
+            points.push_back(onEdge);
+            points.emplace_back(std::nextafter(onEdge.x, box.minX - 1.0), onEdge.y);
+            points.emplace_back(std::nextafter(onEdge.x, box.maxX + 1.0), onEdge.y);
+        }
+    }
+    for (double x = std::floor(box.minX) - 1.0; x <= box.maxX + 1.0; x += 0.5)
+    {
+        for (double y = std::floor(box.minY) - 1.0; y <= box.maxY + 1.0; y += 0.5)
+        {
+            points.emplace_back(x, y);
+        }
+    }
+
+    std::unique_ptr<bool[]> results(new bool[points.size()]);
+    index.containsPoints(points.data(), points.size(), results.get());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        bool expected = containsPointNaively(polygon, points[i].x, points[i].y);
+        if (index.containsPoint(points[i].x, points[i].y) != expected || results[i] != expected)
+        {
+            mismatches++;
+        }
+    }
+    pointCount = points.size();
+    return mismatches;
+}
+
+/** Squared distance from a point to a segment, with the same arithmetic as `SegmentIndex`. */
+double segmentDistanceSquared(const eil::OrientedLineSegment &segment, const eil::Point &point)
+{
+    eil::Point direction(segment.point2.x - segment.point1.x, segment.point2.y - segment.point1.y);
+    double lengthSquared = direction.x * direction.x + direction.y * direction.y;
+    double inverseLengthSquared = lengthSquared > 0.0 ? 1.0 / lengthSquared : 0.0;
+    double t = ((point.x - segment.point1.x) * direction.x + (point.y - segment.point1.y) * direction.y)
+               * inverseLengthSquared;
+    t = std::max(0.0, std::min(1.0, t));
+    double dX = point.x - (segment.point1.x + t * direction.x);
+    double dY = point.y - (segment.point1.y + t * direction.y);
+    return dX * dX + dY * dY;
+}
+
+/** Venue with a wavy 1,200-vertex boundary and 300 doors and windows along it. */
+eil::LocationRef segmentVenue()
+{
+    std::vector<eil::Point> boundary;
+    for (int i = 0; i < 1200; i++)
+    {
+        double angle = -2.0 * kPi * i / 1200.0;
+        double radius = 60.0 + 8.0 * std::sin(i * 0.37) + 3.0 * (i % 2);
+        boundary.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+    }
+    eil::LocationBuilder builder;
+    builder.setLocationBoundaryPoints(boundary);
+    for (size_t i = 0; i < 300; i++)
+    {
+        if (i % 3 == 0)
+        {
+            builder.addWindow(0.8, i * 4, 0.2, eil::LocationBuilderSide::Left);
+        }
+        else
+        {
+            builder.addDoor(0.8, i * 4, 0.2, eil::LocationBuilderSide::Left);
+        }
+    }
+    builder.addBeacon("verify", eil::OrientedPoint(0.0, 0.0));
+    return builder.build();
+}
+
+/**
+ * Compares the nearest segment queries of `SegmentIndex` with a scan of all segments on random points, a random walk
+ * and points on segments, for several kind filters. The closest distance has to be exactly the same; of equally distant
+ * segments any may be returned. Batched queries have to return exactly what single queries return.
+ *
+ * @return Number of queries with a different answer.
+ */
+size_t verifySegmentIndex(const eil::Location &location, eil::Random &random, size_t &queryCount)
+{
+    const eil::SegmentIndex &index = location.segmentIndex();
+    const eil::Rect &box = location.boundingBox();
+    std::vector<std::pair<const eil::OrientedLineSegment *, unsigned>> segments;
+    for (const eil::OrientedLineSegment &wall : location.boundarySegments())
+    {
+        segments.emplace_back(&wall, eil::kWallSegments);
+    }
+    for (const eil::LinearObject &object : location.linearObjects())
+    {
+        segments.emplace_back(&object.position,
+                              object.type == eil::LinearObjectType::Door ? eil::kDoorSegments : eil::kWindowSegments);
+    }
+
+    std::vector<eil::Point> points;
+    for (int i = 0; i < 20000; i++)
+    {
+        points.emplace_back(random.uniform(box.minX - 5.0, box.maxX + 5.0), random.uniform(box.minY - 5.0, box.maxY + 5.0));
+    }
+    eil::Point walker(0.0, 0.0);
+    for (int i = 0; i < 20000; i++)
+    {
+        walker = eil::Point(walker.x + random.uniform(-0.3, 0.3), walker.y + random.uniform(-0.3, 0.3));
+        points.push_back(walker);
+    }
+    for (const auto &segment : segments)
+    {
+        const eil::OrientedLineSegment &line = *segment.first;
+        double t = random.uniform();
+        points.push_back(line.point1);
+        points.emplace_back(line.point1.x + (line.point2.x - line.point1.x) * t,
+                            line.point1.y + (line.point2.y - line.point1.y) * t);
+    }
+
+    size_t mismatches = 0;
+    queryCount = 0;
+    std::vector<eil::SegmentHit> hits(points.size());
+    std::vector<double> distances(points.size());
+    const unsigned filters[] = {eil::kAllSegments, eil::kWallSegments, eil::kDoorSegments,
+                                eil::kDoorSegments | eil::kWindowSegments};
+    for (unsigned kinds : filters)
+    {
+        index.nearestSegments(points.data(), points.size(), hits.data(), kinds);
+        index.distancesToNearest(points.data(), points.size(), distances.data(), kinds);
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            double best = std::numeric_limits<double>::infinity();
+            for (const auto &segment : segments)
+            {
+                if (segment.second & kinds)
+                {
+                    best = std::min(best, segmentDistanceSquared(*segment.first, points[i]));
+                }
+            }
+            eil::SegmentHit single = index.nearestSegment(points[i], kinds);
+            const eil::OrientedLineSegment *found = nullptr;
+            if (single.kind == eil::kWallSegments)
+            {
+                found = &location.boundarySegments()[single.index];
+            }
+            else if (single.found())
+            {
+                found = &location.linearObjects()[single.index].position;
+            }
+            bool matches = found != nullptr && single.distance == std::sqrt(best)
+                           && segmentDistanceSquared(*found, points[i]) == best && (single.kind & kinds)
+                           && hits[i].kind == single.kind && hits[i].index == single.index
+                           && hits[i].distance == single.distance && distances[i] == single.distance;
+            if (!matches)
+            {
+                mismatches++;
+            }
+        }
+        queryCount += points.size();
+    }
+    return mismatches;
+}
+
+/** Venue of 100 m × 100 m with 2,500 pins of a few common types, some on a one-meter lattice, and 70 rare types. */
+eil::LocationRef pinVenue(eil::Random &random)
+{
+    eil::LocationBuilder builder;
+    builder.setLocationBoundaryPoints({{0.0, 0.0}, {0.0, 100.0}, {100.0, 100.0}, {100.0, 0.0}});
+    const char *types[] = {"shelf", "exit", "cashier", "poi"};
+    for (int i = 0; i < 2500; i++)
+    {
+        double x = random.uniform(0.0, 100.0);
+        double y = random.uniform(0.0, 100.0);
+        // Lattice points give exact ties in distance, which have to be broken by index.
+        if (i % 10 == 0)
+        {
+            x = std::floor(x);
+            y = std::floor(y);
+        }
+        builder.addLocationPin("pin", types[i % 4 == 3 ? 3 : (i % 7 == 0 ? 1 : i % 3)], eil::OrientedPoint(x, y));
+    }
+    for (int i = 0; i < 70; i++)
+    {
+        builder.addLocationPin("rare", "type" + std::to_string(i),
+                               eil::OrientedPoint(random.uniform(0.0, 100.0), random.uniform(0.0, 100.0)));
+    }
+    builder.addBeacon("verify", eil::OrientedPoint(50.0, 50.0));
+    return builder.build();
+}
+
+/**
+ * Compares nearest and radius queries of `PinIndex` with a sorted scan of all pins, with and without type filters.
+ * Hits have to be exactly the same, in the same order.
+ *
+ * @return Number of queries with a different answer.
+ */
+size_t verifyPinIndex(const eil::Location &location, eil::Random &random, size_t &queryCount)
+{
+    const eil::PinIndex &index = location.pinIndex();
+    const std::vector<eil::LocationPin> &pins = location.locationPins();
+    const std::string filters[] = {"", "shelf", "exit", "poi", "type5", "type69", "missing"};
+    auto isCloser = [](const eil::PinHit &a, const eil::PinHit &b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+    };
+
+    size_t mismatches = 0;
+    std::vector<eil::PinHit> hits;
+    std::vector<eil::PinHit> expected;
+    queryCount = 20000;
+    for (size_t query = 0; query < queryCount; query++)
+    {
+        eil::Point point(std::floor(random.uniform(-10.0, 110.0)), std::floor(random.uniform(-10.0, 110.0)));
+        if (query % 3 == 0)
+        {
+            point = eil::Point(random.uniform(-10.0, 110.0), random.uniform(-10.0, 110.0));
+        }
+        const std::string &type = filters[query % 7];
+        size_t count = 1 + query % 12;
+        double radius = random.uniform(0.0, 12.0);
+        bool radiusQuery = query % 2 == 1;
+        if (radiusQuery)
+        {
+            index.pinsWithinRadius(radius, point, hits, type);
+        }
+        else
+        {
+            index.pinsNearestToPoint(point, count, hits, type);
+        }
+
+        expected.clear();
+        for (size_t i = 0; i < pins.size(); i++)
+        {
+            if (!type.empty() && pins[i].type != type)
+            {
+                continue;
+            }
+            double dX = point.x - pins[i].position.x;
+            double dY = point.y - pins[i].position.y;
+            eil::PinHit hit;
+            hit.index = i;
+            hit.distance = dX * dX + dY * dY;
+            expected.push_back(hit);
+        }
+        std::sort(expected.begin(), expected.end(), isCloser);
+        size_t kept = 0;
+        while (kept < expected.size() && (radiusQuery ? expected[kept].distance <= radius * radius : kept < count))
+        {
+            kept++;
+        }
+        expected.resize(kept);
+
+        bool matches = hits.size() == expected.size();
+        for (size_t i = 0; matches && i < hits.size(); i++)
+        {
+            matches = hits[i].index == expected[i].index && hits[i].distance == std::sqrt(expected[i].distance);
+        }
+        if (!matches)
+        {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+/** Runs all checks of --verify-indexes. @return true if every index matched brute force. */
+bool verifyIndexes(uint64_t seed)
+{
+    eil::Random random(seed);
+    size_t totalMismatches = 0;
+    auto report = [&totalMismatches](const std::string &check, size_t queries, size_t mismatches) {
+        std::printf("%-40s %9zu queries %6zu mismatches\n", check.c_str(), queries, mismatches);
+        totalMismatches += mismatches;
+    };
+
+    size_t pointCount = 0;
+    size_t mismatches = verifyPolygonIndex(starPolygon(random), random, pointCount);
+    report("PolygonIndex, 200-vertex star", pointCount, mismatches);
+    mismatches = verifyPolygonIndex(combPolygon(), random, pointCount);
+    report("PolygonIndex, 202-vertex comb", pointCount, mismatches);
+
+    size_t queryCount = 0;
+    eil::LocationRef venue = segmentVenue();
+    mismatches = verifySegmentIndex(*venue, random, queryCount);
+    report("SegmentIndex, " + std::to_string(venue->segmentIndex().segmentCount()) + " segments", queryCount, mismatches);
+
+    venue = pinVenue(random);
+    mismatches = verifyPinIndex(*venue, random, queryCount);
+    report("PinIndex, " + std::to_string(venue->pinIndex().pinCount()) + " pins", queryCount, mismatches);
+
+    return totalMismatches == 0;
+}
+
+/** Office floor of 40 rooms on both sides of a 120 m corridor, entered through 1.2 m doors, with a pin in every room. */
+eil::LocationRef routingVenue()
+{
+    std::vector<eil::Point> boundary = {{0.0, 10.0}};
+    for (int i = 0; i < 20; i++)
+    {
+        double x = i * 6.0;
+        boundary.insert(boundary.end(), {{x + 2.4, 10.0}, {x + 2.4, 9.8}, {x + 0.5, 9.8}, {x + 0.5, 0.0}, {x + 5.5, 0.0},
+                                         {x + 5.5, 9.8}, {x + 3.6, 9.8}, {x + 3.6, 10.0}});
+    }
+    boundary.insert(boundary.end(), {{120.0, 10.0}, {120.0, 13.0}});
+    for (int i = 19; i >= 0; i--)
+    {
+        double x = i * 6.0;
+        boundary.insert(boundary.end(), {{x + 3.6, 13.0}, {x + 3.6, 13.2}, {x + 5.5, 13.2}, {x + 5.5, 23.0},
+                                         {x + 0.5, 23.0}, {x + 0.5, 13.2}, {x + 2.4, 13.2}, {x + 2.4, 13.0}});
+    }
+    boundary.push_back({0.0, 13.0});
+
+    eil::LocationBuilder builder;
+    builder.setLocationBoundaryPoints(boundary);
+    for (int i = 0; i < 20; i++)
+    {
+        builder.addLocationPin("room", "office", eil::OrientedPoint(i * 6.0 + 3.0, 1.0));
+        builder.addLocationPin("room", "office", eil::OrientedPoint(i * 6.0 + 3.0, 22.0));
+    }
+    builder.addBeacon("routing", eil::OrientedPoint(60.0, 11.5));
+    return builder.build();
+}
+
+/**
+ * Measures routing on `routingVenue`: building the graph and the pin distance fields, and answering `distanceToPin`,
+ * `routeToPin` and `findRoute` from random points, as when rerouting on every position update. The lengths from the
+ * fields have to match A*.
+ *
+ * @return true if every route length matched.
+ */
+bool benchmarkRouting(uint64_t seed)
+{
+    typedef std::chrono::steady_clock Clock;
+    auto microseconds = [](Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double, std::micro>(end - start).count();
+    };
+    auto report = [](const char *operation, size_t count, double totalMicroseconds) {
+        std::printf("%-40s %9zu calls %10.2f us/call\n", operation, count, totalMicroseconds / count);
+    };
+
+    eil::LocationRef venue = routingVenue();
+    if (!venue)
+    {
+        std::fprintf(stderr, "Could not build the routing venue.\n");
+        return false;
+    }
+    // Queries stay within the pins whose fields are cached, so they measure answering from a field and not building one.
+    size_t maximumFields = eil::NavigationGraph::kMaximumCachedPinFields;
+    const size_t fieldCount = std::min(venue->locationPins().size(), maximumFields);
+    Clock::time_point start = Clock::now();
+    const eil::NavigationGraph &graph = venue->navigationGraph();
+    report("NavigationGraph", 1, microseconds(start, Clock::now()));
+    std::printf("%-40s %9zu nodes %10zu edges\n", "", graph.nodeCount(), graph.edgeCount());
+
+    start = Clock::now();
+    for (size_t pin = 0; pin < fieldCount; pin++)
+    {
+        graph.pinDistanceField(pin);
+    }
+    report("DistanceField", fieldCount, microseconds(start, Clock::now()));
+
+    const size_t queryCount = 20000;
+    eil::Random random(seed);
+    std::vector<eil::Point> starts;
+    std::vector<size_t> pins;
+    for (size_t i = 0; i < queryCount; i++)
+    {
+        starts.push_back(venue->randomPointInside(random));
+        pins.push_back(i % fieldCount);
+    }
+
+    std::vector<double> fieldLengths(queryCount);
+    start = Clock::now();
+    for (size_t i = 0; i < queryCount; i++)
+    {
+        fieldLengths[i] = graph.distanceToPin(starts[i], pins[i]);
+    }
+    report("NavigationGraph::distanceToPin", queryCount, microseconds(start, Clock::now()));
+
+    eil::Route route;
+    start = Clock::now();
+    for (size_t i = 0; i < queryCount; i++)
+    {
+        graph.routeToPin(starts[i], pins[i], route);
+    }
+    report("NavigationGraph::routeToPin", queryCount, microseconds(start, Clock::now()));
+
+    size_t mismatches = 0;
+    double searchTime = 0.0;
+    for (size_t i = 0; i < queryCount; i++)
+    {
+        start = Clock::now();
+        bool found = graph.findRoute(starts[i], venue->locationPins()[pins[i]].position, route);
+        searchTime += microseconds(start, Clock::now());
+        if (!found || std::abs(route.length - fieldLengths[i]) > 1e-9 * std::max(route.length, 1.0))
+        {
+            mismatches++;
+        }
+    }
+    report("NavigationGraph::findRoute", queryCount, searchTime);
+    std::printf("%-40s %9zu queries %6zu mismatches\n", "Field length against A*", queryCount, mismatches);
+    return mismatches == 0;
+}
+
+long peakResidentKilobytes()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+Result runVenue(const Venue &venue, double duration, uint64_t seed)
+{
+    const eil::Location &location = *venue.location;
+    eil::AlgorithmParameters parameters;
+    parameters.randomSeed = seed;
+    Walk walk(location);
+    std::vector<double> errors;
+    size_t updates = 0;
+
+    eil::PositioningEngine engine(venue.location, parameters);
+    engine.setPositionHandler([&](const eil::PositionUpdate &update, const eil::Location &) {
+        updates++;
+        eil::Point truth = walk.positionAt(update.timestamp);
+        errors.push_back(update.position.distanceTo(truth));
+    });
+
+    // Samples are generated up front, so only the engine is measured.
+    eil::Random random(seed);
+    std::vector<eil::BeaconSample> samples;
+    const std::vector<eil::PositionedBeacon> &beacons = location.beacons();
+    std::vector<double> phases(beacons.size());
+    for (double &phase : phases)
+    {
+        phase = random.uniform(0.0, kAdvertisingInterval);
+    }
+    for (double tick = 0.0; tick < duration; tick += kAdvertisingInterval)
+    {
+        size_t first = samples.size();
+        for (size_t i = 0; i < beacons.size(); i++)
+        {
+            double timestamp = tick + phases[i];
+            eil::Point position = walk.positionAt(timestamp);
+            double distance = std::max(0.5, position.distanceTo(beacons[i].position));
+            double rssi = parameters.measuredPower - 10.0 * parameters.pathLossExponent * std::log10(distance)
+                          + random.normal(0.0, 4.0);
+            if (rssi < kReceiverSensitivity || random.uniform() < kPacketLoss)
+            {
+                continue;
+            }
+            samples.push_back({beacons[i].beacon, timestamp, static_cast<int>(std::lround(rssi))});
+        }
+        std::sort(samples.begin() + first, samples.end(), [](const eil::BeaconSample &a, const eil::BeaconSample &b) {
+            return a.timestamp < b.timestamp;
+        });
+    }
+
+    std::clock_t cpuStart = std::clock();
+    auto wallStart = std::chrono::steady_clock::now();
+    for (const eil::BeaconSample &sample : samples)
+    {
+        engine.processSample(sample);
+    }
+    engine.advanceTo(duration);
+    auto wallEnd = std::chrono::steady_clock::now();
+    std::clock_t cpuEnd = std::clock();
+
+    Result result;
+    result.area = venue.area;
+    result.beaconCount = beacons.size();
+    result.samples = samples.size();
+    result.updates = updates;
+    result.cpuTime = static_cast<double>(cpuEnd - cpuStart) / CLOCKS_PER_SEC;
+    result.wallTime = std::chrono::duration<double>(wallEnd - wallStart).count();
+    if (!errors.empty())
+    {
+        double sum = 0.0;
+        for (double error : errors)
+        {
+            sum += error;
+        }
+        result.meanError = sum / errors.size();
+        std::sort(errors.begin(), errors.end());
+        result.p90Error = errors[std::min(errors.size() - 1, static_cast<size_t>(errors.size() * 0.9))];
+    }
+    result.peakResidentKilobytes = peakResidentKilobytes();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    double duration = 600.0;
+    uint64_t seed = 1;
+    bool csv = false;
+    bool verify = false;
+    bool routing = false;
+    std::vector<double> areas = {10.0, 100.0, 1000.0, 10000.0};
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--duration") == 0 && i + 1 < argc)
+        {
+            duration = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--area") == 0 && i + 1 < argc)
+        {
+            areas = {std::atof(argv[++i])};
+        }
+        else if (std::strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+        }
+        else if (std::strcmp(argv[i], "--verify-indexes") == 0)
+        {
+            verify = true;
+        }
+        else if (std::strcmp(argv[i], "--routing") == 0)
+        {
+            routing = true;
+        }
+        else
+        {
+            std::fprintf(stderr,
+                         "Usage: %s [--duration <seconds>] [--seed <seed>] [--area <m²>] [--csv]\n"
+                         "       %s --verify-indexes [--seed <seed>]\n"
+                         "       %s --routing [--seed <seed>]\n",
+                         argv[0], argv[0], argv[0]);
+            return 2;
+        }
+    }
+    if (verify)
+    {
+        return verifyIndexes(seed) ? 0 : 1;
+    }
+    if (routing)
+    {
+        return benchmarkRouting(seed) ? 0 : 1;
+    }
+    if (!(duration > 0.0) || !(areas.front() > 0.0))
+    {
+        std::fprintf(stderr, "Duration and area have to be positive.\n");
+        return 2;
+    }
+
+    if (csv)
+    {
+        std::printf("area,beacons,samples,updates,updatesPerCpuSecond,cpuPerUpdateMs,wallTime,meanError,p90Error,peakRssKb\n");
+    }
+    else
+    {
+        std::printf("%10s %8s %9s %8s %12s %12s %10s %10s %12s\n", "area [m²]", "beacons", "samples", "updates",
+                    "updates/s", "cpu/upd [ms]", "err [m]", "p90 [m]", "peak RSS [KB]");
+    }
+    // Peak RSS is a high-water mark of the whole process, so venues are run from the smallest to the largest.
+    for (double area : areas)
+    {
+        Venue venue = buildVenue(area);
+        if (!venue.location)
+        {
+            std::fprintf(stderr, "Could not build a venue of %.0f m².\n", area);
+            return 1;
+        }
+        Result result = runVenue(venue, duration, seed);
+        double updatesPerSecond = result.cpuTime > 0.0 ? result.updates / result.cpuTime : 0.0;
+        double cpuPerUpdate = result.updates > 0 ? result.cpuTime / result.updates * 1e3 : 0.0;
+        if (csv)
+        {
+            std::printf("%.0f,%zu,%zu,%zu,%.1f,%.4f,%.4f,%.3f,%.3f,%ld\n", result.area, result.beaconCount, result.samples,
+                        result.updates, updatesPerSecond, cpuPerUpdate, result.wallTime, result.meanError, result.p90Error,
+                        result.peakResidentKilobytes);
+        }
+        else
+        {
+            std::printf("%10.0f %8zu %9zu %8zu %12.1f %12.4f %10.2f %10.2f %12ld\n", result.area, result.beaconCount,
+                        result.samples, result.updates, updatesPerSecond, cpuPerUpdate, result.meanError, result.p90Error,
+                        result.peakResidentKilobytes);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+//  Copyright © 2017 Estimote. All rights reserved.
+
+// Replays a scan trace recorded by TraceWriter through the positioning engine.
+//
+// Usage: eil-replay [--quiet] [--seed <seed>] [--signal-maps <directory>] [--step-length <meters>] <trace>
+//
+// Position updates are printed to standard output as CSV, statistics to standard error. With --signal-maps, precomputed
+// signal maps are stored in and mapped from the directory. With a non-zero --seed, replays of the same trace produce
+// bit-identical output. Sensor samples in the trace are fused in step with the beacon samples, with the step length
+// given by --step-length, so traces of the inertial positioning mode replay through the same pipeline.
+
+#include "EILCore/EILCore.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    bool quiet = false;
+    eil::AlgorithmParameters parameters;
+    std::string signalMapDirectory;
+    double stepLength = 0.0;
+    std::string path;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--quiet") == 0)
+        {
+            quiet = true;
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            parameters.randomSeed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--signal-maps") == 0 && i + 1 < argc)
+        {
+            signalMapDirectory = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--step-length") == 0 && i + 1 < argc)
+        {
+            stepLength = std::atof(argv[++i]);
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    if (path.empty())
+    {
+        std::fprintf(stderr, "Usage: %s [--quiet] [--seed <seed>] [--signal-maps <directory>] [--step-length <meters>] <trace>\n",
+                     argv[0]);
+        return 2;
+    }
+
+    eil::TraceReplayer replayer(parameters);
+    if (!signalMapDirectory.empty())
+    {
+        replayer.setSignalMapCache(std::make_shared<eil::SignalMapCache>(signalMapDirectory));
+    }
+    if (stepLength > 0.0)
+    {
+        replayer.setInertialStepLength(stepLength);
+    }
+    if (!quiet)
+    {
+        std::printf("location,timestamp,x,y,orientation,accuracy,accuracyRadius\n");
+        replayer.setPositionHandler([](const eil::PositionUpdate &update, const eil::Location &location) {
+            const std::string &name = location.identifier().empty() ? location.name() : location.identifier();
+            std::printf("%s,%.6f,%.3f,%.3f,%.1f,%d,%.3f\n", name.c_str(), update.timestamp, update.position.x, update.position.y,
+                        update.position.orientation, static_cast<int>(update.accuracy), update.accuracyRadius);
+        });
+    }
+
+    if (!replayer.replay(path))
+    {
+        std::fprintf(stderr, "Could not replay %s: missing file, invalid header or no location recorded.\n", path.c_str());
+        return 1;
+    }
+
+    const eil::TraceReplayStatistics &statistics = replayer.statistics();
+    std::fprintf(stderr, "beacon samples:     %zu\n", statistics.beaconSamples);
+    std::fprintf(stderr, "sensor samples:     %zu\n", statistics.sensorSamples);
+    std::fprintf(stderr, "position updates:   %zu\n", statistics.positionUpdates);
+    std::fprintf(stderr, "trace duration:     %.3f s\n", statistics.traceDuration);
+    std::fprintf(stderr, "engine wall time:   %.6f s (%.0fx real time)\n", statistics.wallTime, statistics.speedup());
+    std::fprintf(stderr, "engine cpu time:    %.6f s\n", statistics.cpuTime);
+    std::fprintf(stderr, "cpu time / update:  %.3f ms\n", statistics.cpuTimePerUpdate() * 1e3);
+    if (statistics.truncated)
+    {
+        std::fprintf(stderr, "warning: trace ends with an incomplete record\n");
+    }
+    return 0;
+}
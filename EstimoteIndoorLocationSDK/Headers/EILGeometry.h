@@ -0,0 +1,282 @@
+//  Copyright (c) 2017 Estimote. All rights reserved.
+
+#import <Foundation/Foundation.h>
+#import <math.h>
+#import "EILPoint.h"
+#import "EILOrientedPoint.h"
+#import "EILOrientedLineSegment.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * Plain value counterparts of `EILPoint`, `EILOrientedPoint` and `EILOrientedLineSegment`.
+ *
+ * The structs live on the stack and all functions below are inline, so geometry on hot paths never allocates. Objects
+ * are converted only at the boundary to APIs taking objects. Structs have the memory layout of the points and segments
+ * of the portable positioning core (`eil::Point`, `eil::OrientedPoint`, `eil::OrientedLineSegment`), so arrays of them
+ * can be passed between the two without copying.
+ *
+ * Coordinates are in meters, orientations in degrees counted clockwise, like in the object API.
+ */
+
+/** Value counterpart of `EILPoint`. */
+typedef struct EILPointValue
+{
+    /** X coordinate of the point. */
+    double x;
+    /** Y coordinate of the point. */
+    double y;
+} EILPointValue;
+
+/** Value counterpart of `EILOrientedPoint`. */
+typedef struct EILOrientedPointValue
+{
+    /** X coordinate of the point. */
+    double x;
+    /** Y coordinate of the point. */
+    double y;
+    /** Orientation of the point. If not defined takes EIL_ORIENTATION_UNDEFINED value. */
+    double orientation;
+} EILOrientedPointValue;
+
+/** Value counterpart of `EILOrientedLineSegment`. */
+typedef struct EILOrientedLineSegmentValue
+{
+    /** Coordinates of the first end point of the line segment. */
+    EILPointValue point1;
+    /** Coordinates of the second end point of the line segment. */
+    EILPointValue point2;
+    /** Orientation associated with the line segment. If not defined takes EIL_ORIENTATION_UNDEFINED value. */
+    double orientation;
+} EILOrientedLineSegmentValue;
+
+#pragma mark Points
+///-----------------------------------------
+/// @name Points
+///-----------------------------------------
+
+/** Returns a point value initialized with (x, y). */
+NS_INLINE EILPointValue EILPointValueMake(double x, double y)
+{
+    EILPointValue point = {x, y};
+    return point;
+}
+
+/** Returns YES if both coordinates of the points are equal. */
+NS_INLINE BOOL EILPointValueEqualToPoint(EILPointValue point1, EILPointValue point2)
+{
+    return point1.x == point2.x && point1.y == point2.y;
+}
+
+/** Translates the point by a given vector (dX, dY). Counterpart of `pointTranslatedBydX:dY:`. */
+NS_INLINE EILPointValue EILPointValueTranslate(EILPointValue point, double dX, double dY)
+{
+    return EILPointValueMake(point.x + dX, point.y + dY);
+}
+
+/** Computes distance between the points. Counterpart of `distanceToPoint:`. */
+NS_INLINE double EILPointValueDistance(EILPointValue point1, EILPointValue point2)
+{
+    return hypot(point2.x - point1.x, point2.y - point1.y);
+}
+
+/** Computes the length of the vector represented by the point. Counterpart of `length`. */
+NS_INLINE double EILPointValueLength(EILPointValue point)
+{
+    return hypot(point.x, point.y);
+}
+
+/**
+ * Rotates the point around a center.
+ *
+ * @param point The point.
+ * @param center Center of the rotation.
+ * @param angle Angle of the rotation in degrees, counted clockwise like orientations.
+ * @return The rotated point.
+ */
+NS_INLINE EILPointValue EILPointValueRotate(EILPointValue point, EILPointValue center, double angle)
+{
+    double radians = angle * M_PI / 180.0;
+    double cosine = cos(radians);
+    double sine = sin(radians);
+    double dX = point.x - center.x;
+    double dY = point.y - center.y;
+    return EILPointValueMake(center.x + dX * cosine + dY * sine, center.y - dX * sine + dY * cosine);
+}
+
+#pragma mark Oriented Points
+///-----------------------------------------
+/// @name Oriented Points
+///-----------------------------------------
+
+/** Returns an oriented point value initialized with (x, y, orientation). */
+NS_INLINE EILOrientedPointValue EILOrientedPointValueMake(double x, double y, double orientation)
+{
+    EILOrientedPointValue point = {x, y, orientation};
+    return point;
+}
+
+/** Returns the position of the oriented point without its orientation. */
+NS_INLINE EILPointValue EILOrientedPointValueGetPoint(EILOrientedPointValue point)
+{
+    return EILPointValueMake(point.x, point.y);
+}
+
+/** Returns YES if the orientation of the point is defined. */
+NS_INLINE BOOL EILOrientedPointValueHasOrientation(EILOrientedPointValue point)
+{
+    return point.orientation != EIL_ORIENTATION_UNDEFINED;
+}
+
+/** Translates the oriented point by a given vector (dX, dY), keeping its orientation. */
+NS_INLINE EILOrientedPointValue EILOrientedPointValueTranslate(EILOrientedPointValue point, double dX, double dY)
+{
+    return EILOrientedPointValueMake(point.x + dX, point.y + dY, point.orientation);
+}
+
+/** Rotates the oriented point around a center. A defined orientation turns along, staying in [0, 360). */
+NS_INLINE EILOrientedPointValue EILOrientedPointValueRotate(EILOrientedPointValue point, EILPointValue center,
+                                                            double angle)
+{
+    EILPointValue rotated = EILPointValueRotate(EILOrientedPointValueGetPoint(point), center, angle);
+    double orientation = point.orientation;
+    if (orientation != EIL_ORIENTATION_UNDEFINED)
+    {
+        orientation = fmod(orientation + angle, 360.0);
+        orientation = orientation < 0.0 ? orientation + 360.0 : orientation;
+    }
+    return EILOrientedPointValueMake(rotated.x, rotated.y, orientation);
+}
+
+#pragma mark Line Segments
+///-----------------------------------------
+/// @name Line Segments
+///-----------------------------------------
+
+/** Returns a line segment value initialized with (point1, point2, orientation). */
+NS_INLINE EILOrientedLineSegmentValue EILOrientedLineSegmentValueMake(EILPointValue point1, EILPointValue point2,
+                                                                      double orientation)
+{
+    EILOrientedLineSegmentValue line = {point1, point2, orientation};
+    return line;
+}
+
+/** Calculates the length of the line segment. Counterpart of `length`. */
+NS_INLINE double EILOrientedLineSegmentValueLength(EILOrientedLineSegmentValue line)
+{
+    return EILPointValueDistance(line.point1, line.point2);
+}
+
+/** Calculates the center point of the line segment, oriented like the segment. Counterpart of `centerPoint`. */
+NS_INLINE EILOrientedPointValue EILOrientedLineSegmentValueCenter(EILOrientedLineSegmentValue line)
+{
+    return EILOrientedPointValueMake((line.point1.x + line.point2.x) / 2.0, (line.point1.y + line.point2.y) / 2.0,
+                                     line.orientation);
+}
+
+/** Translates the line segment by a given vector (dX, dY). Counterpart of `lineTranslatedBydX:dY:`. */
+NS_INLINE EILOrientedLineSegmentValue EILOrientedLineSegmentValueTranslate(EILOrientedLineSegmentValue line,
+                                                                           double dX, double dY)
+{
+    return EILOrientedLineSegmentValueMake(EILPointValueTranslate(line.point1, dX, dY),
+                                           EILPointValueTranslate(line.point2, dX, dY), line.orientation);
+}
+
+/** Finds the point of the line segment closest to a given point. */
+NS_INLINE EILPointValue EILOrientedLineSegmentValueClosestPoint(EILOrientedLineSegmentValue line, EILPointValue point)
+{
+    double dX = line.point2.x - line.point1.x;
+    double dY = line.point2.y - line.point1.y;
+    double lengthSquared = dX * dX + dY * dY;
+    if (lengthSquared == 0.0)
+    {
+        return line.point1;
+    }
+    double t = ((point.x - line.point1.x) * dX + (point.y - line.point1.y) * dY) / lengthSquared;
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    return EILPointValueMake(line.point1.x + t * dX, line.point1.y + t * dY);
+}
+
+/** Computes the distance from a given point to the closest point of the line segment. */
+NS_INLINE double EILOrientedLineSegmentValueDistanceToPoint(EILOrientedLineSegmentValue line, EILPointValue point)
+{
+    return EILPointValueDistance(point, EILOrientedLineSegmentValueClosestPoint(line, point));
+}
+
+/** Returns YES if the line segments have at least one common point. */
+NS_INLINE BOOL EILOrientedLineSegmentValueIntersects(EILOrientedLineSegmentValue line1,
+                                                     EILOrientedLineSegmentValue line2)
+{
+    EILPointValue p = line1.point1, q = line2.point1;
+    double rX = line1.point2.x - p.x, rY = line1.point2.y - p.y;
+    double sX = line2.point2.x - q.x, sY = line2.point2.y - q.y;
+    double denominator = rX * sY - rY * sX;
+    double qpX = q.x - p.x, qpY = q.y - p.y;
+    if (denominator == 0.0)
+    {
+        // Parallel segments only meet if they lie on the same line and their projections overlap.
+        if (qpX * rY - qpY * rX != 0.0)
+        {
+            return NO;
+        }
+        double lengthSquared = rX * rX + rY * rY;
+        if (lengthSquared == 0.0)
+        {
+            return EILOrientedLineSegmentValueDistanceToPoint(line2, p) == 0.0;
+        }
+        double t0 = (qpX * rX + qpY * rY) / lengthSquared;
+        double t1 = t0 + (sX * rX + sY * rY) / lengthSquared;
+        return (t0 < t1 ? t0 : t1) <= 1.0 && (t0 < t1 ? t1 : t0) >= 0.0;
+    }
+    double t = (qpX * sY - qpY * sX) / denominator;
+    double u = (qpX * rY - qpY * rX) / denominator;
+    return t >= 0.0 && t <= 1.0 && u >= 0.0 && u <= 1.0;
+}
+
+#pragma mark Converting To and From Objects
+///-----------------------------------------
+/// @name Converting To and From Objects
+///-----------------------------------------
+
+/** Reads the coordinates of a point object. Does not allocate. */
+NS_INLINE EILPointValue EILPointValueFromPoint(EILPoint *point)
+{
+    return EILPointValueMake(point.x, point.y);
+}
+
+/** Creates a point object with the coordinates of the value. */
+NS_INLINE EILPoint *EILPointFromValue(EILPointValue point)
+{
+    return [EILPoint pointWithX:point.x y:point.y];
+}
+
+/** Reads the coordinates and orientation of an oriented point object. Does not allocate. */
+NS_INLINE EILOrientedPointValue EILOrientedPointValueFromOrientedPoint(EILOrientedPoint *point)
+{
+    return EILOrientedPointValueMake(point.x, point.y, point.orientation);
+}
+
+/** Creates an oriented point object with the coordinates and orientation of the value. */
+NS_INLINE EILOrientedPoint *EILOrientedPointFromValue(EILOrientedPointValue point)
+{
+    return [EILOrientedPoint pointWithX:point.x y:point.y orientation:point.orientation];
+}
+
+/** Reads the end points and orientation of a line segment object. Does not allocate. */
+NS_INLINE EILOrientedLineSegmentValue EILOrientedLineSegmentValueFromLine(EILOrientedLineSegment *line)
+{
+    return EILOrientedLineSegmentValueMake(EILPointValueFromPoint(line.point1), EILPointValueFromPoint(line.point2),
+                                           line.orientation);
+}
+
+/** Creates a line segment object with the end points and orientation of the value. */
+NS_INLINE EILOrientedLineSegment *EILOrientedLineSegmentFromValue(EILOrientedLineSegmentValue line)
+{
+    return [EILOrientedLineSegment lineWithX1:line.point1.x
+                                           y1:line.point1.y
+                                           x2:line.point2.x
+                                           y2:line.point2.y
+                                  orientation:line.orientation];
+}
+
+NS_ASSUME_NONNULL_END
@@ -17,6 +17,7 @@
 #import "EILPoint.h"
 #import "EILOrientedPoint.h"
 #import "EILOrientedLineSegment.h"
+#import "EILGeometry.h"
 #import "EILLocationLinearObject.h"
 #import "EILPositionedBeacon.h"
 #import "EILLocation.h"